@@ -0,0 +1,80 @@
+#include "deck.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+
+using namespace TheGameAnalyzer;
+
+// Time generating and dealing decks, separately from playing them.
+int main()
+{
+    const uint32_t NUM_DECKS = 1'000'000;
+    // Cards a typical 3-5 player game draws before it ends.
+    const size_t NUM_CARDS_DRAWN = 80;
+
+    auto report = [&](const std::string &name, size_t num_cards_drawn, auto &&deal)
+    {
+        long long checksum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t seed = 0; seed < NUM_DECKS; ++seed)
+        {
+            checksum += deal(seed);
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+        std::cout << "{ \"deck\": \"" << name << "\""
+                  << ", \"num_cards_drawn\": " << num_cards_drawn
+                  << ", \"num_decks\": " << NUM_DECKS
+                  << ", \"ns_per_deck\": " << ns / NUM_DECKS
+                  << ", \"checksum\": " << checksum
+                  << "}\n";
+    };
+
+    report("std::shuffle", NUM_CARDS_IN_DECK, [](uint32_t seed)
+           {
+               Deck deck(NUM_CARDS_IN_DECK);
+               std::iota(deck.begin(), deck.end(), 2);
+               std::mt19937 gen32(seed);
+               std::shuffle(deck.begin(), deck.end(), gen32);
+               return deck.back(); });
+    for (const auto deck_rng : {DeckRng::StdCompat, DeckRng::Xoshiro256})
+    {
+        for (const size_t num_cards_drawn : {NUM_CARDS_DRAWN, NUM_CARDS_IN_DECK})
+        {
+            report(to_string(deck_rng), num_cards_drawn, [=](uint32_t seed)
+                   {
+                       ShuffledDeck deck(seed, deck_rng);
+                       long long sum = 0;
+                       for (size_t i = 0; i < num_cards_drawn; ++i)
+                       {
+                           sum += deck.draw();
+                       }
+                       return sum; });
+        }
+    }
+
+    const std::string path = "bench_deck_corpus.bin";
+    write_deck_corpus(path, NUM_DECKS, DeckRng::StdCompat);
+    {
+        const DeckCorpus deck_corpus(path);
+        for (const size_t num_cards_drawn : {NUM_CARDS_DRAWN, NUM_CARDS_IN_DECK})
+        {
+            report("corpus", num_cards_drawn, [&](uint32_t seed)
+                   {
+                       ShuffledDeck deck = deck_corpus.get_deck(seed);
+                       long long sum = 0;
+                       for (size_t i = 0; i < num_cards_drawn; ++i)
+                       {
+                           sum += deck.draw();
+                       }
+                       return sum; });
+        }
+    }
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "game.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+using namespace TheGameAnalyzer;
+
+// Time play_game() serially over the same seeds for each number of players.
+// Then time the README's reach distance triangle (normal 0-6, endgame
+// normal-13) played one configuration at a time against play_game_forked().
+int main()
+{
+    const uint32_t NUM_GAMES = 10'000;
+    for (int num_players = MIN_PLAYERS; num_players <= MAX_PLAYERS; ++num_players)
+    {
+        long long num_cards_remaining = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t seed = 0; seed < NUM_GAMES; ++seed)
+        {
+            num_cards_remaining += play_game(seed, num_players, 1, 1, PrintGame::No);
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+        std::cout << "{ \"num_players\": " << num_players
+                  << ", \"num_games\": " << NUM_GAMES
+                  << ", \"ns_per_game\": " << ns / NUM_GAMES
+                  << ", \"cards_remaining\": " << num_cards_remaining
+                  << "}\n";
+    }
+
+    const uint32_t NUM_FORKED_GAMES = 500;
+    std::vector<CardReachDistances> configs;
+    for (int r = 0; r <= 6; ++r)
+    {
+        for (int e = r; e <= 13; ++e)
+        {
+            configs.push_back({r, e});
+        }
+    }
+    std::vector<int> num_cards_remaining_forked(configs.size());
+    for (int num_players = MIN_PLAYERS; num_players <= MAX_PLAYERS; ++num_players)
+    {
+        for (const bool do_fork : {false, true})
+        {
+            long long num_cards_remaining = 0;
+            const auto start = std::chrono::steady_clock::now();
+            for (uint32_t seed = 0; seed < NUM_FORKED_GAMES; ++seed)
+            {
+                const ShuffledDeck deck(seed, DeckRng::StdCompat);
+                if (do_fork)
+                {
+                    play_game_forked(deck, num_players, configs.data(), configs.size(), TurnEngine::Greedy,
+                                     num_cards_remaining_forked.data());
+                    num_cards_remaining += std::accumulate(num_cards_remaining_forked.begin(),
+                                                           num_cards_remaining_forked.end(), 0LL);
+                }
+                else
+                {
+                    for (const auto &config : configs)
+                    {
+                        num_cards_remaining += play_game(deck, num_players, config.normal, config.endgame);
+                    }
+                }
+            }
+            const auto stop = std::chrono::steady_clock::now();
+            const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+            std::cout << "{ \"num_players\": " << num_players
+                      << ", \"forked\": " << (do_fork ? "true" : "false")
+                      << ", \"num_configs\": " << configs.size()
+                      << ", \"num_decks\": " << NUM_FORKED_GAMES
+                      << ", \"ns_per_deck\": " << ns / NUM_FORKED_GAMES
+                      << ", \"cards_remaining\": " << num_cards_remaining
+                      << "}\n";
+        }
+    }
+    return 0;
+}
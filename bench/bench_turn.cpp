@@ -0,0 +1,199 @@
+#include "game.hpp"
+#include "turn.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace TheGameAnalyzer;
+
+// A turn from a recorded game.
+struct Position
+{
+    Piles piles;
+    Hand hand;
+    HandMask hand_mask;
+    int min_cards_for_turn;
+    int card_reach_distance;
+    Deck deck;
+};
+
+static std::vector<int> parse_cards(const std::string &s)
+{
+    std::vector<int> cards;
+    std::istringstream is(s);
+    char c;
+    int card;
+    while (is >> c && c != '}')
+    {
+        if (is >> card)
+        {
+            cards.push_back(card);
+        }
+    }
+    return cards;
+}
+
+// Add the turns of games printed as PrintGame::Yes does (e.g. game_outcomes/
+// or decode_game_trace()).
+//
+// The deck of each position is the cards not yet dealt, in no particular
+// order, for timing draw_cards().
+static void add_positions(std::istream &is, int card_reach_distance_normal, int card_reach_distance_endgame,
+                          std::vector<Position> &positions)
+{
+    const std::regex game_re(R"(seed: \d+, deck: (\{.*\}))");
+    const std::regex turn_re(R"((\{.*\}), hand: \d+, (\{.*\}), 0x([0-9a-f]+))");
+    size_t deck_size = 0;
+    std::string line;
+    std::smatch m;
+    while (std::getline(is, line))
+    {
+        if (std::regex_match(line, m, game_re))
+        {
+            deck_size = parse_cards(m[1]).size();
+        }
+        else if (std::regex_match(line, m, turn_re))
+        {
+            Position position;
+            const auto piles = parse_cards(m[1]);
+            std::copy(piles.begin(), piles.end(), position.piles.begin());
+            for (const auto card : parse_cards(m[2]))
+            {
+                position.hand.push_back(static_cast<Card>(card));
+            }
+            position.hand_mask = static_cast<HandMask>(std::stoul(m[3], nullptr, 16));
+            position.min_cards_for_turn = deck_size > 0 ? 2 : 1;
+            position.card_reach_distance = deck_size > 0 ? card_reach_distance_normal : card_reach_distance_endgame;
+            for (Card card = 2; card < 100 && position.deck.size() < deck_size; ++card)
+            {
+                if (std::find(position.hand.begin(), position.hand.end(), card) == position.hand.end())
+                {
+                    position.deck.push_back(card);
+                }
+            }
+            positions.push_back(position);
+            deck_size -= std::min(deck_size, static_cast<size_t>(get_num_cards_in_hand_mask(position.hand_mask)));
+        }
+    }
+}
+
+// Time the turn engine and game loop on turns from recorded games: the games
+// in game_outcomes/ and NUM_GAMES games per number of players recorded with
+// --trace. Each line is JSON with ns per op, and turns per second for the
+// ops that play whole turns or games.
+int main()
+{
+    const uint32_t NUM_GAMES = 2'000;
+    const int CARD_REACH_DISTANCE = 1;
+    const std::string trace_path = "bench_turn_trace.bin";
+
+    std::vector<Position> positions;
+    std::vector<size_t> num_turns_per_players(MAX_PLAYERS + 1);
+    for (int num_players = MIN_PLAYERS; num_players <= MAX_PLAYERS; ++num_players)
+    {
+        {
+            GameTraceFile game_trace(trace_path);
+            play_games(num_players, CARD_REACH_DISTANCE, CARD_REACH_DISTANCE, NUM_GAMES, false, TurnEngine::Greedy, 0,
+                       DeckRng::StdCompat, nullptr, {}, &game_trace);
+            game_trace.close();
+        }
+        std::ifstream trace(trace_path, std::ios::binary);
+        std::stringstream games;
+        decode_game_trace(trace, games);
+        const size_t num_positions = positions.size();
+        add_positions(games, CARD_REACH_DISTANCE, CARD_REACH_DISTANCE, positions);
+        num_turns_per_players[num_players] = positions.size() - num_positions;
+    }
+    std::remove(trace_path.c_str());
+
+    const std::regex outcome_re(R"(n\d+s\d+r(\d+)e(\d+)\.txt)");
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator("game_outcomes", ec))
+    {
+        std::smatch m;
+        const std::string file_name = entry.path().filename().string();
+        if (std::regex_match(file_name, m, outcome_re))
+        {
+            std::ifstream is(entry.path());
+            add_positions(is, std::stoi(m[1]), std::stoi(m[2]), positions);
+        }
+    }
+
+    std::vector<TenGroups> ten_groups;
+    for (const auto &position : positions)
+    {
+        ten_groups.push_back(get_ten_groups(position.hand));
+    }
+
+    auto report = [](const std::string &name, int num_players, size_t num_ops, size_t num_turns, auto &&op)
+    {
+        long long checksum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < num_ops; ++i)
+        {
+            checksum += op(i);
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+        std::cout << "{ \"bench\": \"" << name << "\"";
+        if (num_players != 0)
+        {
+            std::cout << ", \"num_players\": " << num_players;
+        }
+        std::cout << ", \"num_ops\": " << num_ops
+                  << ", \"ns_per_op\": " << ns / num_ops;
+        if (num_turns != 0)
+        {
+            std::cout << ", \"turns_per_second\": " << num_turns / ns * 1e9;
+        }
+        std::cout << ", \"checksum\": " << checksum
+                  << "}\n";
+    };
+
+    // Enough passes over the positions for about a million ops.
+    const size_t num_position_ops = positions.size() * std::max(size_t{1}, 1'000'000 / positions.size());
+    auto position = [&](size_t i) -> const Position & { return positions[i % positions.size()]; };
+
+    report("get_ten_groups", 0, num_position_ops, 0, [&](size_t i)
+           { return get_ten_groups(position(i).hand).groups_hand_mask; });
+    report("get_plays_ascending", 0, num_position_ops, 0, [&](size_t i)
+           {
+               const auto &p = position(i);
+               const Card bound_card = p.piles[0] <= p.piles[1] ? p.piles[1] : 100;
+               return get_plays_ascending(p.piles[0], bound_card, 0, p.hand, ten_groups[i % positions.size()],
+                                          p.min_cards_for_turn, p.card_reach_distance)
+                   .size(); });
+    report("find_best_turn", 0, num_position_ops, num_position_ops, [&](size_t i)
+           {
+               const auto &p = position(i);
+               return find_best_turn(p.piles, p.hand, p.min_cards_for_turn, p.card_reach_distance).hand_mask; });
+    // Includes copying the deck and hand.
+    report("draw_cards", 0, num_position_ops, 0, [&](size_t i)
+           {
+               const auto &p = position(i);
+               Deck deck = p.deck;
+               Hand hand = p.hand;
+               draw_cards(deck, hand, p.hand_mask);
+               return hand.empty() ? 0 : hand.back(); });
+
+    for (int num_players = MIN_PLAYERS; num_players <= MAX_PLAYERS; ++num_players)
+    {
+        const size_t num_turns = num_turns_per_players[num_players];
+        report("play_game", num_players, NUM_GAMES, num_turns, [&](size_t seed)
+               { return play_game(static_cast<uint32_t>(seed), num_players, CARD_REACH_DISTANCE, CARD_REACH_DISTANCE,
+                                  PrintGame::No); });
+        report("play_games", num_players, 1, num_turns, [&](size_t)
+               { return static_cast<long long>(play_games(num_players, CARD_REACH_DISTANCE, CARD_REACH_DISTANCE,
+                                                          NUM_GAMES, false)
+                                                   .cards_left_average); });
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "turn.hpp"
+
+#include <cstdint>
+
+namespace TheGameAnalyzer
+{
+    // Set of card values [0 - 127] stored as one bit per card value.
+    //
+    // Finding a card, the next card above a pile or a ten-group chain is a
+    // shift/AND/count-trailing-zeros instead of a scan over a sorted hand.
+    class CardSet
+    {
+    public:
+        using Bits = unsigned __int128;
+
+        CardSet() = default;
+        explicit CardSet(Bits bits) : bits_(bits) {}
+        template <typename Cards>
+        explicit CardSet(const Cards &cards)
+        {
+            for (const auto c : cards)
+            {
+                insert(c);
+            }
+        }
+
+        Bits bits() const { return bits_; }
+        bool empty() const { return bits_ == 0; }
+        int size() const { return __builtin_popcountll(lo()) + __builtin_popcountll(hi()); }
+
+        void insert(Card c) { bits_ |= bit(c); }
+        void erase(Card c) { bits_ &= ~bit(c); }
+        bool contains(Card c) const { return (bits_ & bit(c)) != 0; }
+
+        // Lowest card in the set. Set must not be empty.
+        Card lowest() const
+        {
+            return static_cast<Card>(lo() != 0 ? __builtin_ctzll(lo()) : 64 + __builtin_ctzll(hi()));
+        }
+
+        // Highest card in the set. Set must not be empty.
+        Card highest() const
+        {
+            return static_cast<Card>(hi() != 0 ? 127 - __builtin_clzll(hi()) : 63 - __builtin_clzll(lo()));
+        }
+
+        // Cards > c.
+        CardSet above(Card c) const { return CardSet(bits_ & ~((bit(c) << 1) - 1)); }
+
+        // Cards < c.
+        CardSet below(Card c) const { return CardSet(bits_ & (bit(c) - 1)); }
+
+        // Cards c where lo < c < hi.
+        CardSet between(Card lo, Card hi) const { return above(lo).below(hi); }
+
+        // Number of cards < c. For a sorted hand this is the hand index of c.
+        size_t rank(Card c) const { return static_cast<size_t>(below(c).size()); }
+
+        // Cards c where c + n is in the set.
+        CardSet shifted_down(int n) const { return CardSet(bits_ >> n); }
+
+        // Cards c where c - n is in the set.
+        CardSet shifted_up(int n) const { return CardSet(bits_ << n); }
+
+        CardSet operator&(CardSet other) const { return CardSet(bits_ & other.bits_); }
+        CardSet operator|(CardSet other) const { return CardSet(bits_ | other.bits_); }
+        CardSet operator~() const { return CardSet(~bits_); }
+        bool operator==(CardSet other) const { return bits_ == other.bits_; }
+        bool operator!=(CardSet other) const { return bits_ != other.bits_; }
+
+    private:
+        static Bits bit(Card c) { return Bits{1} << c; }
+        uint64_t lo() const { return static_cast<uint64_t>(bits_); }
+        uint64_t hi() const { return static_cast<uint64_t>(bits_ >> 64); }
+
+        Bits bits_{0};
+    };
+
+    std::string to_string(CardSet card_set);
+
+} // namespace TheGameAnalyzer
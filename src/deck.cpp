@@ -0,0 +1,235 @@
+#include "deck.hpp"
+
+#include "card_set.hpp"
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace TheGameAnalyzer
+{
+    static uint64_t splitmix64(uint64_t &x)
+    {
+        uint64_t z = (x += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    static uint64_t rotl(uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    Xoshiro256::Xoshiro256(uint64_t seed)
+    {
+        for (auto &s : s_)
+        {
+            s = splitmix64(seed);
+        }
+    }
+
+    Xoshiro256::result_type Xoshiro256::operator()()
+    {
+        const uint64_t result = rotl(s_[1] * 5, 7) * 9;
+        const uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return result;
+    }
+
+    uint32_t get_bounded(Xoshiro256 &rng, uint32_t range)
+    {
+        uint64_t product = (rng() >> 32) * range;
+        uint32_t low = static_cast<uint32_t>(product);
+        if (low < range)
+        {
+            const uint32_t threshold = -range % range;
+            while (low < threshold)
+            {
+                product = (rng() >> 32) * range;
+                low = static_cast<uint32_t>(product);
+            }
+        }
+        return static_cast<uint32_t>(product >> 32);
+    }
+
+    // libstdc++'s uniform_int_distribution for a 32 bit generator: [0, range).
+    static uint64_t get_bounded_std_compat(std::mt19937 &gen32, uint64_t range)
+    {
+        assert(range <= UINT32_MAX);
+        const uint32_t range32 = static_cast<uint32_t>(range);
+        uint64_t product = uint64_t{gen32()} * range32;
+        uint32_t low = static_cast<uint32_t>(product);
+        if (low < range32)
+        {
+            const uint32_t threshold = -range32 % range32;
+            while (low < threshold)
+            {
+                product = uint64_t{gen32()} * range32;
+                low = static_cast<uint32_t>(product);
+            }
+        }
+        return product >> 32;
+    }
+
+    void shuffle_std_compat(Card *first, Card *last, std::mt19937 &gen32)
+    {
+        if (first == last)
+        {
+            return;
+        }
+        const uint64_t num_cards = static_cast<uint64_t>(last - first);
+        // For small ranges libstdc++ gets two swap positions from each random number.
+        assert(UINT32_MAX / num_cards >= num_cards);
+        Card *it = first + 1;
+        if (num_cards % 2 == 0)
+        {
+            std::iter_swap(it++, first + get_bounded_std_compat(gen32, 2));
+        }
+        while (it != last)
+        {
+            const uint64_t swap_range = static_cast<uint64_t>(it - first) + 1;
+            const uint64_t x = get_bounded_std_compat(gen32, swap_range * (swap_range + 1));
+            std::iter_swap(it++, first + x / (swap_range + 1));
+            std::iter_swap(it++, first + x % (swap_range + 1));
+        }
+    }
+
+    ShuffledDeck::ShuffledDeck(uint32_t seed, DeckRng deck_rng)
+        : cards_(NUM_CARDS_IN_DECK), rng_(seed), is_lazy_(deck_rng == DeckRng::Xoshiro256)
+    {
+        TGA_METRICS_TIMER(Metric::DeckShuffle);
+        std::iota(cards_.begin(), cards_.end(), 2);
+        if (deck_rng == DeckRng::StdCompat)
+        {
+            std::mt19937 gen32(seed);
+            shuffle_std_compat(cards_.begin(), cards_.end(), gen32);
+        }
+    }
+
+    Card ShuffledDeck::draw()
+    {
+        assert(!cards_.empty());
+        if (is_lazy_ && cards_.size() > 1)
+        {
+            // One Fisher-Yates step fixes the back card.
+            const uint32_t i = static_cast<uint32_t>(cards_.size() - 1);
+            std::swap(cards_[i], cards_[get_bounded(rng_, i + 1)]);
+        }
+        const Card card = cards_.back();
+        cards_.pop_back();
+        return card;
+    }
+
+    void ShuffledDeck::shuffle_rest()
+    {
+        if (!is_lazy_)
+        {
+            return;
+        }
+        for (uint32_t i = static_cast<uint32_t>(cards_.size()); i-- > 1;)
+        {
+            std::swap(cards_[i], cards_[get_bounded(rng_, i + 1)]);
+        }
+        is_lazy_ = false;
+    }
+
+    std::string to_string(DeckRng deck_rng)
+    {
+        switch (deck_rng)
+        {
+        case DeckRng::StdCompat:
+            return "std-compat";
+        case DeckRng::Xoshiro256:
+            return "xoshiro256";
+        }
+        assert(false);
+        return "";
+    }
+
+    DeckCorpus::DeckCorpus(const std::string &path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Can't open deck corpus: " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size == 0 || st.st_size % NUM_CARDS_IN_DECK != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Deck corpus size isn't a whole number of decks: " + path);
+        }
+        const size_t num_bytes = static_cast<size_t>(st.st_size);
+        void *data = ::mmap(nullptr, num_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            throw std::runtime_error("Can't map deck corpus: " + path);
+        }
+        data_ = static_cast<const uint8_t *>(data);
+        num_decks_ = num_bytes / NUM_CARDS_IN_DECK;
+
+        // Check once here so get_deck() doesn't have to.
+        for (size_t i = 0; i < num_decks_; ++i)
+        {
+            CardSet cards;
+            for (size_t j = 0; j < NUM_CARDS_IN_DECK; ++j)
+            {
+                const Card c = data_[i * NUM_CARDS_IN_DECK + j];
+                if (c < 2 || c > 99 || cards.contains(c))
+                {
+                    ::munmap(const_cast<uint8_t *>(data_), num_bytes);
+                    throw std::runtime_error("Deck " + std::to_string(i) + " isn't a deck of cards [2 - 99]: " + path);
+                }
+                cards.insert(c);
+            }
+        }
+    }
+
+    DeckCorpus::~DeckCorpus()
+    {
+        ::munmap(const_cast<uint8_t *>(data_), num_decks_ * NUM_CARDS_IN_DECK);
+    }
+
+    ShuffledDeck DeckCorpus::get_deck(size_t index) const
+    {
+        assert(index < num_decks_);
+        const uint8_t *first = data_ + index * NUM_CARDS_IN_DECK;
+        return ShuffledDeck(Deck(first, first + NUM_CARDS_IN_DECK));
+    }
+
+    void write_deck_corpus(const std::string &path, uint64_t num_decks, DeckRng deck_rng)
+    {
+        std::ofstream ofs(path, std::ios::binary);
+        std::array<char, NUM_CARDS_IN_DECK> bytes;
+        for (uint64_t seed = 0; seed < num_decks && ofs; ++seed)
+        {
+            ShuffledDeck deck(static_cast<uint32_t>(seed), deck_rng);
+            deck.shuffle_rest();
+            std::copy(deck.get_cards().begin(), deck.get_cards().end(), bytes.begin());
+            ofs.write(bytes.data(), bytes.size());
+        }
+        ofs.close();
+        if (!ofs)
+        {
+            throw std::runtime_error("Can't write deck corpus: " + path);
+        }
+    }
+
+} // namespace TheGameAnalyzer
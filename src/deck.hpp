@@ -0,0 +1,102 @@
+#pragma once
+
+#include "turn.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+namespace TheGameAnalyzer
+{
+    // How the deck is shuffled.
+    enum class DeckRng
+    {
+        StdCompat,  // std::mt19937 and libstdc++'s std::shuffle. Decks behind the README numbers.
+        Xoshiro256, // xoshiro256** and Fisher-Yates, the same on every platform. Dealt lazily.
+    };
+
+    // xoshiro256** (https://prng.di.unimi.it/), seeded with splitmix64.
+    class Xoshiro256
+    {
+    public:
+        using result_type = uint64_t;
+
+        explicit Xoshiro256(uint64_t seed);
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return UINT64_MAX; }
+        result_type operator()();
+
+    private:
+        uint64_t s_[4];
+    };
+
+    // Unbiased random number in [0, range) (Lemire's method).
+    uint32_t get_bounded(Xoshiro256 &rng, uint32_t range);
+
+    // The same permutation as libstdc++'s std::shuffle(first, last, gen32)
+    // (GCC 11 and later), whatever standard library we're built with.
+    void shuffle_std_compat(Card *first, Card *last, std::mt19937 &gen32);
+
+    // Shuffled deck [2 - 99], dealt from the back.
+    //
+    // With DeckRng::Xoshiro256 the Fisher-Yates shuffle runs from the back of
+    // the deck, so each card is fixed just as it's drawn and cards left in
+    // the deck at the end of the game are never shuffled.
+    class ShuffledDeck
+    {
+    public:
+        ShuffledDeck() : rng_(0), is_lazy_(false) {}
+        ShuffledDeck(uint32_t seed, DeckRng deck_rng);
+        // Deck already shuffled, e.g. from a DeckCorpus. Cards as get_cards().
+        explicit ShuffledDeck(const Deck &cards) : cards_(cards), rng_(0), is_lazy_(false) {}
+
+        bool empty() const { return cards_.empty(); }
+        size_t size() const { return cards_.size(); }
+
+        // Take the card from the back of the deck.
+        Card draw();
+
+        // Shuffle any cards not yet shuffled, e.g. to print the deck. Doesn't
+        // change the order the cards are drawn in.
+        void shuffle_rest();
+
+        // Cards in the deck, drawn from the back. Call shuffle_rest() first.
+        const Deck &get_cards() const { return cards_; }
+
+    private:
+        Deck cards_;
+        Xoshiro256 rng_;
+        bool is_lazy_;
+    };
+
+    std::string to_string(DeckRng deck_rng);
+
+    // Shuffled decks from a file, memory mapped.
+    //
+    // The file is just decks back to back, NUM_CARDS_IN_DECK bytes each: one
+    // byte per card in the order of ShuffledDeck::get_cards() (the last card
+    // is drawn first). So decks from real games can be added by hand.
+    class DeckCorpus
+    {
+    public:
+        // Throws std::runtime_error if the file can't be mapped or has a bad deck.
+        explicit DeckCorpus(const std::string &path);
+        ~DeckCorpus();
+        DeckCorpus(const DeckCorpus &) = delete;
+        DeckCorpus &operator=(const DeckCorpus &) = delete;
+
+        size_t size() const { return num_decks_; }
+        ShuffledDeck get_deck(size_t index) const;
+
+    private:
+        const uint8_t *data_{nullptr};
+        size_t num_decks_{0};
+    };
+
+    // Write the decks for seeds [0, num_decks) as a DeckCorpus file.
+    //
+    // Throws std::runtime_error if the file can't be written.
+    void write_deck_corpus(const std::string &path, uint64_t num_decks, DeckRng deck_rng);
+
+} // namespace TheGameAnalyzer
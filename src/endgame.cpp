@@ -0,0 +1,299 @@
+#include "endgame.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace TheGameAnalyzer
+{
+    static const char ENDGAME_TABLEBASE_MAGIC[8] = {'T', 'G', 'A', 'E', 'G', 'T', 'B', '1'};
+    static const size_t ENDGAME_TABLEBASE_HEADER_SIZE = sizeof(ENDGAME_TABLEBASE_MAGIC) + sizeof(uint64_t);
+    static const size_t ENDGAME_TABLEBASE_POSITION_SIZE = 2 * sizeof(uint64_t) + 1; // Key and max cards played.
+
+    bool operator==(const EndgameKey &k1, const EndgameKey &k2)
+    {
+        return k1.lo == k2.lo && k1.hi == k2.hi;
+    }
+
+    bool operator<(const EndgameKey &k1, const EndgameKey &k2)
+    {
+        return k1.lo != k2.lo ? k1.lo < k2.lo : k1.hi < k2.hi;
+    }
+
+    EndgameKey make_endgame_key(const Piles &piles, CardSet hand)
+    {
+        assert(hand.below(2).empty() && hand.above(99).empty() && "Cards must be [2 - 99]");
+        const auto pile_bits = [](Card c1, Card c2)
+        { return static_cast<uint64_t>(std::min(c1, c2)) | static_cast<uint64_t>(std::max(c1, c2)) << 7; };
+        EndgameKey key;
+        key.lo = static_cast<uint64_t>(hand.bits());
+        key.hi = static_cast<uint64_t>(hand.bits() >> 64);
+        key.hi |= (pile_bits(piles[0], piles[1]) | pile_bits(piles[2], piles[3]) << 14) << 36;
+        return key;
+    }
+
+    size_t EndgameKeyHash::operator()(const EndgameKey &key) const
+    {
+        // splitmix64 finalizer.
+        uint64_t h = key.lo ^ (key.hi * 0x9e3779b97f4a7c15);
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111eb;
+        h ^= h >> 31;
+        return static_cast<size_t>(h);
+    }
+
+    EndgameTablebase::EndgameTablebase(const std::string &path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Can't open endgame tablebase: " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < ENDGAME_TABLEBASE_HEADER_SIZE)
+        {
+            ::close(fd);
+            throw std::runtime_error("Endgame tablebase is too small: " + path);
+        }
+        num_bytes_ = static_cast<size_t>(st.st_size);
+        void *data = ::mmap(nullptr, num_bytes_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            throw std::runtime_error("Can't map endgame tablebase: " + path);
+        }
+        data_ = static_cast<const uint8_t *>(data);
+
+        uint64_t num_positions = 0;
+        std::memcpy(&num_positions, data_ + sizeof(ENDGAME_TABLEBASE_MAGIC), sizeof(num_positions));
+        // Bound the count first, so the size can't overflow.
+        const size_t max_num_positions = (num_bytes_ - ENDGAME_TABLEBASE_HEADER_SIZE) / ENDGAME_TABLEBASE_POSITION_SIZE;
+        if (std::memcmp(data_, ENDGAME_TABLEBASE_MAGIC, sizeof(ENDGAME_TABLEBASE_MAGIC)) != 0 ||
+            num_positions > max_num_positions ||
+            num_bytes_ != ENDGAME_TABLEBASE_HEADER_SIZE + num_positions * ENDGAME_TABLEBASE_POSITION_SIZE)
+        {
+            ::munmap(const_cast<uint8_t *>(data_), num_bytes_);
+            throw std::runtime_error("Not an endgame tablebase: " + path);
+        }
+        num_positions_ = static_cast<size_t>(num_positions);
+        // The header is 16 bytes and mmap is page aligned, so the keys are aligned.
+        keys_ = reinterpret_cast<const uint64_t *>(data_ + ENDGAME_TABLEBASE_HEADER_SIZE);
+        max_cards_played_ = data_ + ENDGAME_TABLEBASE_HEADER_SIZE + num_positions_ * 2 * sizeof(uint64_t);
+    }
+
+    EndgameTablebase::~EndgameTablebase()
+    {
+        ::munmap(const_cast<uint8_t *>(data_), num_bytes_);
+    }
+
+    std::optional<int> EndgameTablebase::find(const EndgameKey &key) const
+    {
+        // Binary search of the keys, two words each.
+        size_t first = 0;
+        size_t last = num_positions_;
+        while (first < last)
+        {
+            const size_t mid = first + (last - first) / 2;
+            const EndgameKey mid_key{keys_[2 * mid], keys_[2 * mid + 1]};
+            if (mid_key < key)
+            {
+                first = mid + 1;
+            }
+            else
+            {
+                last = mid;
+            }
+        }
+        if (first < num_positions_ && EndgameKey{keys_[2 * first], keys_[2 * first + 1]} == key)
+        {
+            return max_cards_played_[first];
+        }
+        return std::nullopt;
+    }
+
+    int EndgameSolver::solve(const Piles &piles, const Hand &hand)
+    {
+        return static_cast<int>(hand.size()) - get_max_cards_played(piles, CardSet(hand));
+    }
+
+    int EndgameSolver::get_max_cards_played(const Piles &piles, CardSet hand)
+    {
+        if (hand.empty())
+        {
+            return 0;
+        }
+        const EndgameKey key = make_endgame_key(piles, hand);
+        if (const auto it = table_.find(key); it != table_.end())
+        {
+            return it->second;
+        }
+        if (tablebase_ != nullptr)
+        {
+            if (const auto max_cards_played = tablebase_->find(key))
+            {
+                return *max_cards_played;
+            }
+        }
+
+        const int hand_size = hand.size();
+        int max_cards_played = 0;
+        for (CardSet cards = hand; !cards.empty() && max_cards_played < hand_size; cards.erase(cards.lowest()))
+        {
+            const Card c = cards.lowest();
+            CardSet rest = hand;
+            rest.erase(c);
+            for (size_t i = 0; i < piles.size() && max_cards_played < hand_size; ++i)
+            {
+                // Same pile card as the other pile in this direction: same position.
+                if ((i == 1 || i == 3) && piles[i] == piles[i - 1])
+                {
+                    continue;
+                }
+                const bool is_playable = i < 2 ? c > piles[i] || c == piles[i] - 10
+                                               : c < piles[i] || c == piles[i] + 10;
+                if (is_playable)
+                {
+                    Piles next_piles = piles;
+                    next_piles[i] = c;
+                    max_cards_played = std::max(max_cards_played, 1 + get_max_cards_played(next_piles, rest));
+                }
+            }
+        }
+        table_.emplace(key, static_cast<uint8_t>(max_cards_played));
+        return max_cards_played;
+    }
+
+    void EndgameSolver::write_tablebase(const std::string &path) const
+    {
+        std::vector<std::pair<EndgameKey, uint8_t>> positions(table_.begin(), table_.end());
+        std::sort(positions.begin(), positions.end(), [](const auto &p1, const auto &p2)
+                  { return p1.first < p2.first; });
+        std::ofstream ofs(path, std::ios::binary);
+        const uint64_t num_positions = positions.size();
+        ofs.write(ENDGAME_TABLEBASE_MAGIC, sizeof(ENDGAME_TABLEBASE_MAGIC));
+        ofs.write(reinterpret_cast<const char *>(&num_positions), sizeof(num_positions));
+        for (const auto &position : positions)
+        {
+            ofs.write(reinterpret_cast<const char *>(&position.first.lo), sizeof(position.first.lo));
+            ofs.write(reinterpret_cast<const char *>(&position.first.hi), sizeof(position.first.hi));
+        }
+        for (const auto &position : positions)
+        {
+            ofs.put(static_cast<char>(position.second));
+        }
+        ofs.close();
+        if (!ofs)
+        {
+            throw std::runtime_error("Can't write endgame tablebase: " + path);
+        }
+    }
+
+    std::string to_string(const EndgameReport &report)
+    {
+        std::ostringstream oss;
+        oss << "{ \"heuristic\": " << to_string(report.heuristic)
+            << ", \"perfect\": " << to_string(report.perfect)
+            << ", \"cards_lost_average\": " << report.cards_lost_average
+            << ", \"games_lost_percent\": " << report.games_lost_percent
+            << ", \"beat_the_game_lost_percent\": " << report.beat_the_game_lost_percent
+            << "}";
+        return oss.str();
+    }
+
+    // Seeds [0, num_trials) are split into chunks of about this many games.
+    static const uint64_t ENDGAME_CHUNK_SIZE = 64;
+
+    EndgameReport play_games_endgame(int card_reach_distance_normal, int card_reach_distance_endgame,
+                                     uint64_t num_trials, bool do_parallel, const EndgameTablebase *tablebase,
+                                     DeckRng deck_rng, const DeckCorpus *deck_corpus,
+                                     SchedulerOptions scheduler_options)
+    {
+        assert(num_trials >= MIN_TRIALS);
+        assert(num_trials <= MAX_TRIALS);
+        assert(deck_corpus == nullptr || num_trials <= deck_corpus->size());
+        const uint64_t num_chunks = (num_trials + ENDGAME_CHUNK_SIZE - 1) / ENDGAME_CHUNK_SIZE;
+        if (!do_parallel)
+        {
+            scheduler_options = SchedulerOptions{1, false};
+        }
+        struct alignas(64) ThreadStats
+        {
+            GamesStats heuristic;
+            GamesStats perfect;
+            uint64_t cards_lost{0};
+            uint64_t games_lost{0};
+            uint64_t beat_the_game_lost{0};
+        };
+        std::vector<ThreadStats> threads_stats(get_num_threads(scheduler_options));
+        auto play_chunk = [&](uint64_t chunk_index, unsigned thread_index)
+        {
+            const uint64_t first_seed = num_trials * chunk_index / num_chunks;
+            const uint64_t last_seed = num_trials * (chunk_index + 1) / num_chunks;
+            auto &thread_stats = threads_stats[thread_index];
+            for (uint64_t seed = first_seed; seed < last_seed; ++seed)
+            {
+                const ShuffledDeck deck = deck_corpus != nullptr ? deck_corpus->get_deck(seed)
+                                                                 : ShuffledDeck(static_cast<uint32_t>(seed), deck_rng);
+                // A fresh table per game: endgames of different games hardly ever meet.
+                EndgameSolver endgame_solver(tablebase);
+                const int heuristic = play_game(deck, 1, card_reach_distance_normal, card_reach_distance_endgame);
+                const int perfect = play_game(deck, 1, card_reach_distance_normal, card_reach_distance_endgame,
+                                              TurnEngine::Greedy, nullptr, Strategy::Basic, &endgame_solver);
+                assert(perfect <= heuristic && "The perfect endgame lost to the heuristic");
+                thread_stats.heuristic.add(heuristic);
+                thread_stats.perfect.add(perfect);
+                thread_stats.cards_lost += static_cast<uint64_t>(heuristic - perfect);
+                thread_stats.games_lost += heuristic != perfect;
+                thread_stats.beat_the_game_lost += heuristic != 0 && perfect == 0;
+            }
+        };
+        parallel_for_chunks(num_chunks, scheduler_options, play_chunk);
+
+        GamesStats heuristic;
+        GamesStats perfect;
+        uint64_t cards_lost = 0;
+        uint64_t games_lost = 0;
+        uint64_t beat_the_game_lost = 0;
+        for (const auto &thread_stats : threads_stats)
+        {
+            heuristic.merge(thread_stats.heuristic);
+            perfect.merge(thread_stats.perfect);
+            cards_lost += thread_stats.cards_lost;
+            games_lost += thread_stats.games_lost;
+            beat_the_game_lost += thread_stats.beat_the_game_lost;
+        }
+        EndgameReport report;
+        report.heuristic = calculate_games_stats(heuristic);
+        report.perfect = calculate_games_stats(perfect);
+        const double n = static_cast<double>(num_trials);
+        report.cards_lost_average = static_cast<double>(cards_lost) / n;
+        report.games_lost_percent = 100.0 * static_cast<double>(games_lost) / n;
+        report.beat_the_game_lost_percent = 100.0 * static_cast<double>(beat_the_game_lost) / n;
+        return report;
+    }
+
+    void write_endgame_tablebase(const std::string &path, int card_reach_distance_normal, uint64_t num_trials,
+                                 DeckRng deck_rng)
+    {
+        // The turns before the endgame don't depend on the endgame reach distance.
+        EndgameSolver endgame_solver;
+        for (uint64_t seed = 0; seed < num_trials; ++seed)
+        {
+            play_game(ShuffledDeck(static_cast<uint32_t>(seed), deck_rng), 1, card_reach_distance_normal,
+                      MIN_CARD_REACH_DISTANCE, TurnEngine::Greedy, nullptr, Strategy::Basic, &endgame_solver);
+        }
+        endgame_solver.write_tablebase(path);
+    }
+
+} // namespace TheGameAnalyzer
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "card_set.hpp"
+#include "game.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace TheGameAnalyzer
+{
+    // Exact encoding of a 1 player endgame position.
+    //
+    // Layout: the hand's CardSet bits (cards [2 - 99]), then the piles at bit
+    // 100 (7 bits each). The two piles of each direction are interchangeable,
+    // so they're stored in order.
+    struct EndgameKey
+    {
+        uint64_t lo{0};
+        uint64_t hi{0};
+    };
+    bool operator==(const EndgameKey &k1, const EndgameKey &k2);
+    bool operator<(const EndgameKey &k1, const EndgameKey &k2);
+
+    EndgameKey make_endgame_key(const Piles &piles, CardSet hand);
+
+    struct EndgameKeyHash
+    {
+        size_t operator()(const EndgameKey &key) const;
+    };
+
+    // Solved endgame positions from a file, memory mapped.
+    //
+    // The file is "TGAEGTB1", the number of positions (uint64_t), the keys in
+    // order (lo then hi, uint64_t each), then one byte per position: the most
+    // cards that can be played from it. Native byte order.
+    class EndgameTablebase
+    {
+    public:
+        // Throws std::runtime_error if the file can't be mapped or isn't a tablebase.
+        explicit EndgameTablebase(const std::string &path);
+        ~EndgameTablebase();
+        EndgameTablebase(const EndgameTablebase &) = delete;
+        EndgameTablebase &operator=(const EndgameTablebase &) = delete;
+
+        size_t size() const { return num_positions_; }
+
+        // \return The most cards that can be played from the position, if it's in the tablebase.
+        std::optional<int> find(const EndgameKey &key) const;
+
+    private:
+        const uint8_t *data_{nullptr};
+        size_t num_bytes_{0};
+        size_t num_positions_{0};
+        const uint64_t *keys_{nullptr};
+        const uint8_t *max_cards_played_{nullptr};
+    };
+
+    // Exact solver for 1 player endgames.
+    //
+    // Once the deck is empty a single player's turns are just a run of single
+    // cards (a turn of several cards is the same as several turns of one), so
+    // the position is only the piles and the hand. The solver tries every
+    // card on every pile and keeps each position it solves in a transposition
+    // table, so the many orders that reach a position share its search.
+    //
+    // Not thread safe: use one solver per thread (they can share a tablebase).
+    class EndgameSolver
+    {
+    public:
+        // \param tablebase If not null, look positions up here before searching.
+        explicit EndgameSolver(const EndgameTablebase *tablebase = nullptr) : tablebase_(tablebase) {}
+
+        // \return The fewest cards that can be left in hand, playing perfectly.
+        int solve(const Piles &piles, const Hand &hand);
+
+        // Number of positions in the transposition table.
+        size_t size() const { return table_.size(); }
+
+        // Write the transposition table as an EndgameTablebase file.
+        //
+        // Throws std::runtime_error if the file can't be written.
+        void write_tablebase(const std::string &path) const;
+
+    private:
+        int get_max_cards_played(const Piles &piles, CardSet hand);
+
+        const EndgameTablebase *tablebase_;
+        std::unordered_map<EndgameKey, uint8_t, EndgameKeyHash> table_;
+    };
+
+    // The heuristic endgame against the perfect one, over the same games.
+    struct EndgameReport
+    {
+        TheGamesResults heuristic;              // card_reach_distance_endgame after the deck runs out.
+        TheGamesResults perfect;                // EndgameSolver after the deck runs out.
+        double cards_lost_average{0.0};         // Average extra cards the heuristic leaves.
+        double games_lost_percent{0.0};         // Percentage of games where the heuristic leaves extra cards.
+        double beat_the_game_lost_percent{0.0}; // Percentage of games only the perfect endgame beats.
+    };
+
+    std::string to_string(const EndgameReport &report);
+
+    // Play 1 player games with the heuristic endgame and with the perfect one.
+    //
+    // Both play the same turns until the deck is empty, so the difference is
+    // just what the heuristic endgame loses.
+    //
+    // \param tablebase If not null, look endgame positions up here first.
+    // See play_games() for the other parameters.
+    EndgameReport play_games_endgame(int card_reach_distance_normal, int card_reach_distance_endgame,
+                                     uint64_t num_trials, bool do_parallel,
+                                     const EndgameTablebase *tablebase = nullptr,
+                                     DeckRng deck_rng = DeckRng::StdCompat,
+                                     const DeckCorpus *deck_corpus = nullptr,
+                                     SchedulerOptions scheduler_options = {});
+
+    // Solve the endgames of 1 player games for seeds [0, num_trials) and
+    // write every position searched as an EndgameTablebase file.
+    //
+    // Throws std::runtime_error if the file can't be written.
+    void write_endgame_tablebase(const std::string &path, int card_reach_distance_normal, uint64_t num_trials,
+                                 DeckRng deck_rng);
+
+} // namespace TheGameAnalyzer
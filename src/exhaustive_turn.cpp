@@ -0,0 +1,300 @@
+#include "exhaustive_turn.hpp"
+
+#include "card_set.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <numeric>
+#include <optional>
+
+namespace TheGameAnalyzer
+{
+    namespace
+    {
+        const size_t NUM_HAND_MASKS = 1 << MAX_HAND_SIZE;
+        const Card NO_CARD = std::numeric_limits<Card>::max();
+
+        // Cards are "oriented" so every pile is searched as an ascending pile.
+        Card orient(Card c, size_t piles_index)
+        {
+            if (piles_index >= 2)
+            {
+                flip_card(c);
+            }
+            return c;
+        }
+
+        // Best way to play exactly hand_mask's cards on one pile.
+        struct PileSubset
+        {
+            HandMask hand_mask{0};
+            Card pile_card_end{NO_CARD};
+            int delta{0};
+            bool reached_for_group{false};
+        };
+
+        struct PileSearch
+        {
+            std::array<Card, MAX_HAND_SIZE> cards; // Oriented.
+            size_t hand_size;
+            Card pile_card;                                // Oriented.
+            int max_delta;                                 // Subsets with a bigger delta can't be in the best turn.
+            std::array<Card, NUM_HAND_MASKS> best_end;     // Oriented, NO_CARD if not playable.
+            std::array<bool, NUM_HAND_MASKS> best_reached; // Best end needs a reach for a group.
+        };
+
+        // Lowest card a pile at last_card could still end on with the remaining cards.
+        //
+        // Every card above the lowest reachable card can be played, and so can
+        // any card 10 below one of those.
+        Card get_lowest_possible_end(CardSet remaining_cards, Card last_card)
+        {
+            Card lowest = last_card;
+            while (true)
+            {
+                CardSet reachable = remaining_cards.above(lowest);
+                reachable.insert(lowest);
+                const CardSet lower = (remaining_cards & reachable.shifted_down(10)).below(lowest);
+                if (lower.empty())
+                {
+                    return lowest;
+                }
+                lowest = lower.lowest();
+            }
+        }
+
+        // Depth first search of every legal order of cards on a pile.
+        //
+        // A "segment" is an upward jump followed by any number of backward-10
+        // moves. It reaches for a group if it has a backward move and still
+        // ends above where it started (the same as Play::is_group_reach()).
+        void search_pile(PileSearch &ps, HandMask hand_mask, CardSet remaining_cards, Card last_card,
+                         Card segment_start, bool segment_has_backward, bool reached_closed)
+        {
+            if (get_lowest_possible_end(remaining_cards, last_card) - ps.pile_card > ps.max_delta)
+            {
+                return;
+            }
+            const bool reached_for_group = reached_closed || (segment_has_backward && last_card > segment_start);
+            if (last_card - ps.pile_card <= ps.max_delta)
+            {
+                auto &best_end = ps.best_end[hand_mask];
+                auto &best_reached = ps.best_reached[hand_mask];
+                if (last_card < best_end || (last_card == best_end && best_reached && !reached_for_group))
+                {
+                    best_end = last_card;
+                    best_reached = reached_for_group;
+                }
+            }
+
+            for (size_t i = 0; i < ps.hand_size; ++i)
+            {
+                const HandMask card_mask = 1 << i;
+                if ((card_mask & hand_mask) != 0)
+                {
+                    continue;
+                }
+                const Card c = ps.cards[i];
+                CardSet next_remaining_cards = remaining_cards;
+                next_remaining_cards.erase(c);
+                if (c > last_card)
+                {
+                    search_pile(ps, hand_mask | card_mask, next_remaining_cards, c, last_card, false, reached_for_group);
+                }
+                else if (c == last_card - 10)
+                {
+                    search_pile(ps, hand_mask | card_mask, next_remaining_cards, c, segment_start, true, reached_closed);
+                }
+            }
+        }
+
+        using PileSubsets = FixedVector<PileSubset, NUM_HAND_MASKS>;
+
+        // All the sets of cards that can be played on a pile with a delta of
+        // at most max_delta, smallest delta first.
+        void get_pile_subsets(const Piles &piles, const Hand &hand, size_t piles_index, int max_delta,
+                              PileSubsets &pile_subsets)
+        {
+            PileSearch ps;
+            ps.hand_size = hand.size();
+            ps.pile_card = orient(piles[piles_index], piles_index);
+            ps.max_delta = max_delta;
+            CardSet cards;
+            for (size_t i = 0; i < hand.size(); ++i)
+            {
+                ps.cards[i] = orient(hand[i], piles_index);
+                cards.insert(ps.cards[i]);
+            }
+            const size_t num_hand_masks = size_t{1} << hand.size();
+            std::fill_n(ps.best_end.begin(), num_hand_masks, NO_CARD);
+            search_pile(ps, 0, cards, ps.pile_card, ps.pile_card, false, false);
+            // Not playing on the pile is always an option.
+            ps.best_end[0] = ps.pile_card;
+            ps.best_reached[0] = false;
+
+            pile_subsets.clear();
+            for (size_t hand_mask = 0; hand_mask < num_hand_masks; ++hand_mask)
+            {
+                if (ps.best_end[hand_mask] != NO_CARD)
+                {
+                    PileSubset subset;
+                    subset.hand_mask = static_cast<HandMask>(hand_mask);
+                    subset.pile_card_end = orient(ps.best_end[hand_mask], piles_index);
+                    subset.delta = ps.best_end[hand_mask] - ps.pile_card;
+                    subset.reached_for_group = ps.best_reached[hand_mask];
+                    pile_subsets.push_back(subset);
+                }
+            }
+            // (std::stable_sort would allocate a temporary buffer.)
+            std::sort(pile_subsets.begin(), pile_subsets.end(), [](const auto &s1, const auto &s2)
+                      { return s1.delta != s2.delta ? s1.delta < s2.delta : s1.hand_mask < s2.hand_mask; });
+        }
+
+        struct CombineSearch
+        {
+            std::array<PileSubsets, 4> piles_subsets;
+            std::array<int, 5> min_delta_rest{}; // Lower bound for the delta of piles [i, 4).
+            TurnCompare turn_compare{0};
+            Turn best_turn;
+        };
+
+        // Branch and bound over which set of cards goes on each pile.
+        void combine_piles(CombineSearch &cs, size_t piles_index, Turn &turn)
+        {
+            if (piles_index == cs.piles_subsets.size())
+            {
+                if (cs.turn_compare(cs.best_turn, turn))
+                {
+                    cs.best_turn = turn;
+                }
+                return;
+            }
+            const bool best_has_min_cards = get_num_cards_in_hand_mask(cs.best_turn.hand_mask) >= cs.turn_compare.min_cards_for_turn;
+            for (const auto &subset : cs.piles_subsets[piles_index])
+            {
+                if (best_has_min_cards &&
+                    turn.delta + subset.delta + cs.min_delta_rest[piles_index + 1] > cs.best_turn.delta)
+                {
+                    // Subsets are sorted by delta, so the rest are no better.
+                    break;
+                }
+                if ((subset.hand_mask & turn.hand_mask) != 0)
+                {
+                    continue;
+                }
+                const Turn prev_turn = turn;
+                if (subset.hand_mask != 0)
+                {
+                    turn.piles[piles_index] = subset.pile_card_end;
+                    turn.hand_mask |= subset.hand_mask;
+                    turn.delta += subset.delta;
+                    turn.piles_indexes[piles_index] = static_cast<size_t>(get_num_cards_in_hand_mask(subset.hand_mask));
+                    turn.reached_for_group = turn.reached_for_group || subset.reached_for_group;
+                }
+                combine_piles(cs, piles_index + 1, turn);
+                turn = prev_turn;
+            }
+        }
+
+        // Play single cards, smallest delta first, while within card_reach_distance.
+        //
+        // Like get_plays_ascending(), don't reach for the near card of a 10-group.
+        void play_reach_cards_exhaustive(const Hand &hand, int card_reach_distance, Turn &t)
+        {
+            while (true)
+            {
+                CardSet remaining_cards;
+                for (size_t i = 0; i < hand.size(); ++i)
+                {
+                    if (((1 << i) & t.hand_mask) == 0)
+                    {
+                        remaining_cards.insert(hand[i]);
+                    }
+                }
+                std::optional<size_t> best_pi;
+                size_t best_i = 0;
+                int best_delta = card_reach_distance + 1;
+                for (size_t pi = 0; pi < t.piles.size(); ++pi)
+                {
+                    const Card pile_card = orient(t.piles[pi], pi);
+                    for (size_t i = 0; i < hand.size(); ++i)
+                    {
+                        if (((1 << i) & t.hand_mask) != 0)
+                        {
+                            continue;
+                        }
+                        const Card c = orient(hand[i], pi);
+                        if (c <= pile_card && c != pile_card - 10)
+                        {
+                            continue;
+                        }
+                        const int delta = c - pile_card;
+                        if (delta >= best_delta)
+                        {
+                            continue;
+                        }
+                        const Card group_card = pi < 2 ? hand[i] + 10 : hand[i] - 10;
+                        if (delta > 0 && group_card > 0 && remaining_cards.contains(group_card))
+                        {
+                            continue;
+                        }
+                        best_pi = pi;
+                        best_i = i;
+                        best_delta = delta;
+                    }
+                }
+                if (!best_pi)
+                {
+                    break;
+                }
+                t.piles[*best_pi] = hand[best_i];
+                t.hand_mask |= 1 << best_i;
+                t.delta += best_delta;
+                ++t.piles_indexes[*best_pi];
+            }
+        }
+    } // namespace
+
+    Turn find_best_turn_exhaustive(const Piles &piles, const Hand &hand,
+                                   int min_cards_for_turn,
+                                   int card_reach_distance)
+    {
+        // The greedy turn (without reaching) bounds the delta of the best turn.
+        const Turn greedy_turn = find_best_turn(piles, hand, min_cards_for_turn, 0);
+        const int max_turn_delta = get_num_cards_in_hand_mask(greedy_turn.hand_mask) >= min_cards_for_turn
+                                       ? greedy_turn.delta
+                                       : std::numeric_limits<int>::max() / 2;
+
+        // Each pile ends on one of the hand cards or doesn't move.
+        std::array<int, 4> min_pile_deltas{};
+        for (size_t pi = 0; pi < piles.size(); ++pi)
+        {
+            for (const auto c : hand)
+            {
+                min_pile_deltas[pi] = std::min(min_pile_deltas[pi], orient(c, pi) - orient(piles[pi], pi));
+            }
+        }
+        const int min_turn_delta = std::accumulate(min_pile_deltas.begin(), min_pile_deltas.end(), 0);
+
+        CombineSearch cs;
+        cs.turn_compare = TurnCompare{min_cards_for_turn};
+        cs.best_turn.piles = piles;
+        for (size_t pi = 0; pi < piles.size(); ++pi)
+        {
+            const int max_pile_delta = max_turn_delta - (min_turn_delta - min_pile_deltas[pi]);
+            get_pile_subsets(piles, hand, pi, max_pile_delta, cs.piles_subsets[pi]);
+        }
+        for (size_t pi = piles.size(); pi-- > 0;)
+        {
+            cs.min_delta_rest[pi] = cs.min_delta_rest[pi + 1] + std::min(0, cs.piles_subsets[pi].front().delta);
+        }
+
+        Turn turn;
+        turn.piles = piles;
+        combine_piles(cs, 0, turn);
+        play_reach_cards_exhaustive(hand, card_reach_distance, cs.best_turn);
+        return cs.best_turn;
+    }
+
+} // namespace TheGameAnalyzer
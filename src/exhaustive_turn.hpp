@@ -0,0 +1,25 @@
+#pragma once
+
+#include "turn.hpp"
+
+namespace TheGameAnalyzer
+{
+    // Find the best turn by considering every legal sequence of cards on every pile.
+    //
+    // Unlike find_best_turn(), which builds one greedy chain of plays per pile,
+    // this searches all ways of splitting the hand across the four piles (and
+    // all legal orders on each pile) and keeps the best turn under TurnCompare.
+    // Reach cards are then played one at a time, smallest delta first, while
+    // the delta is within card_reach_distance.
+    //
+    // Turn::piles_indexes holds the number of cards played on each pile.
+    //
+    // \param piles Game piles.
+    // \param hand Hand (sorted).
+    // \param min_cards_for_turn Minimum cards to be played for this turn.
+    // \param card_reach_distance Amount to "reach" to play another card.
+    Turn find_best_turn_exhaustive(const Piles &piles, const Hand &hand,
+                                   int min_cards_for_turn,
+                                   int card_reach_distance);
+
+} // namespace TheGameAnalyzer
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+namespace TheGameAnalyzer
+{
+    // Vector-like container with inline storage for at most N items. Never allocates.
+    //
+    // Only the subset of the std::vector interface the analyzer needs is provided.
+    template <typename T, size_t N>
+    class FixedVector
+    {
+    public:
+        using value_type = T;
+        using iterator = T *;
+        using const_iterator = const T *;
+
+        FixedVector() = default;
+        explicit FixedVector(size_t count) { resize(count); }
+        FixedVector(std::initializer_list<T> init) : FixedVector(init.begin(), init.end()) {}
+        template <typename InputIt>
+        FixedVector(InputIt first, InputIt last)
+        {
+            for (; first != last; ++first)
+            {
+                push_back(*first);
+            }
+        }
+
+        static constexpr size_t capacity() { return N; }
+        size_t size() const { return num_items_; }
+        bool empty() const { return num_items_ == 0; }
+
+        T &operator[](size_t idx) { return items_[idx]; }
+        const T &operator[](size_t idx) const { return items_[idx]; }
+        T &front() { return items_[0]; }
+        const T &front() const { return items_[0]; }
+        T &back() { return items_[num_items_ - 1]; }
+        const T &back() const { return items_[num_items_ - 1]; }
+
+        iterator begin() { return items_.data(); }
+        iterator end() { return items_.data() + num_items_; }
+        const_iterator begin() const { return items_.data(); }
+        const_iterator end() const { return items_.data() + num_items_; }
+
+        void push_back(const T &item)
+        {
+            assert(num_items_ < N && "FixedVector capacity exceeded");
+            items_[num_items_++] = item;
+        }
+        void pop_back()
+        {
+            assert(num_items_ > 0);
+            --num_items_;
+        }
+        void clear() { num_items_ = 0; }
+
+        // New items are value initialized.
+        void resize(size_t count)
+        {
+            assert(count <= N && "FixedVector capacity exceeded");
+            if (count > num_items_)
+            {
+                std::fill(end(), begin() + count, T{});
+            }
+            num_items_ = static_cast<uint16_t>(count);
+        }
+
+        iterator erase(const_iterator first, const_iterator last)
+        {
+            iterator dest = begin() + (first - begin());
+            const auto new_end = std::copy(last, const_iterator(end()), dest);
+            num_items_ = static_cast<uint16_t>(new_end - begin());
+            return dest;
+        }
+
+    private:
+        std::array<T, N> items_{};
+        uint16_t num_items_{0};
+    };
+
+    template <typename T, size_t N>
+    bool operator==(const FixedVector<T, N> &v1, const FixedVector<T, N> &v2)
+    {
+        return std::equal(v1.begin(), v1.end(), v2.begin(), v2.end());
+    }
+
+    template <typename T, size_t N>
+    bool operator!=(const FixedVector<T, N> &v1, const FixedVector<T, N> &v2)
+    {
+        return !(v1 == v2);
+    }
+
+} // namespace TheGameAnalyzer
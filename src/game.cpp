@@ -1,121 +1,223 @@
 #include "game.hpp"
 
+#include "deck.hpp"
+#include "endgame.hpp"
+#include "exhaustive_turn.hpp"
+#include "game_trace.hpp"
+#include "metrics.hpp"
+#include "strategy.hpp"
 #include "turn.hpp"
 
 #include <algorithm>
 #include <cassert>
 #include <cmath>
-#include <execution>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <numeric>
-#include <random>
 #include <sstream>
 #include <vector>
 
-static size_t calc_num_cards_per_hand(size_t num_players)
+namespace TheGameAnalyzer
 {
-    switch (num_players)
+    static Card draw_card(Deck &deck)
     {
-    case 1:
-        return 8;
-    case 2:
-        return 7;
-    case 3:
-    case 4:
-    case 5:
-        return 6;
+        const Card card = deck.back();
+        deck.pop_back();
+        return card;
     }
-    assert(false);
-}
 
-namespace TheGameAnalyzer
-{
-    void draw_cards(std::vector<Card> &deck, Hand &hand, HandMask hand_mask)
+    static Card draw_card(ShuffledDeck &deck)
     {
+        return deck.draw();
+    }
+
+    template <typename Cards>
+    static void draw_cards_from(Cards &deck, Hand &hand, HandMask hand_mask)
+    {
+        TGA_METRICS_TIMER(Metric::DrawCards);
+        // Drop the played cards, keeping the rest of the hand in order.
+        size_t num_cards_kept = 0;
         for (size_t i = 0; i < hand.size(); ++i)
         {
             const unsigned card_mask = 1 << i;
-            if ((card_mask & hand_mask) != 0)
+            if ((card_mask & hand_mask) == 0)
             {
-                hand[i] = 0;
+                hand[num_cards_kept++] = hand[i];
             }
         }
-        auto hand_it = std::partition(hand.begin(), hand.end(), [](const Card c)
-                                      { return c > 0; });
-        auto num_cards_to_replace = std::min(static_cast<size_t>(hand.end() - hand_it), deck.size());
-        auto deck_it = deck.end() - num_cards_to_replace;
-        hand.erase(std::copy(deck_it, deck.end(), hand_it), hand.end());
-        deck.erase(deck_it, deck.end());
-        std::sort(hand.begin(), hand.end());
+        const auto num_cards_to_replace = std::min(hand.size() - num_cards_kept, deck.size());
+        hand.resize(num_cards_kept);
+
+        // Insert the drawn cards in sorted position.
+        for (size_t i = 0; i < num_cards_to_replace; ++i)
+        {
+            const Card card = draw_card(deck);
+            hand.push_back(card);
+            std::rotate(std::upper_bound(hand.begin(), hand.end() - 1, card), hand.end() - 1, hand.end());
+        }
     }
 
-    size_t get_strongest_starting_hands_index(const Piles &piles, const std::vector<Hand> &hands,
-                                              int min_cards_for_turn, int card_reach_distance)
+    void draw_cards(Deck &deck, Hand &hand, HandMask hand_mask)
     {
-        std::vector<Turn> turns(hands.size());
-        std::transform(hands.begin(), hands.end(), turns.begin(), [=, piles = std::cref(piles)](const auto &h)
-                       { return find_best_turn(piles, h, min_cards_for_turn, card_reach_distance); });
-        const TurnCompare turn_compare{min_cards_for_turn};
-        const auto max_turn_it = std::max_element(turns.begin(), turns.end(), turn_compare);
-        return static_cast<size_t>(max_turn_it - turns.begin());
+        draw_cards_from(deck, hand, hand_mask);
     }
 
-    int play_game(uint32_t seed, int num_players, int card_reach_distance_normal,
-                  int card_reach_distance_endgame, PrintGame print_game)
+    static void draw_cards(ShuffledDeck &deck, Hand &hand, HandMask hand_mask)
     {
-        assert(num_players >= MIN_PLAYERS && "Not enough players");
-        assert(num_players <= MAX_PLAYERS && "Too many players");
-        assert(card_reach_distance_normal >= MIN_CARD_REACH_DISTANCE && "Bad card reach distance");
-        assert(card_reach_distance_normal <= MAX_CARD_REACH_DISTANCE && "Bad card reach distance");
-        assert(card_reach_distance_endgame >= MIN_CARD_REACH_DISTANCE && "Bad card reach distance endgame");
-        assert(card_reach_distance_endgame <= MAX_CARD_REACH_DISTANCE && "Bad card reach distance endgame");
+        draw_cards_from(deck, hand, hand_mask);
+    }
 
-        Piles piles = {1, 1, 100, 100};
-        std::vector<Hand> hands(static_cast<size_t>(num_players));
+    // Add the cards of hand in hand_mask to played_cards.
+    static void add_played_cards(const Hand &hand, HandMask hand_mask, CardSet &played_cards)
+    {
+        for (unsigned mask = hand_mask; mask != 0; mask &= mask - 1)
+        {
+            played_cards.insert(hand[static_cast<size_t>(__builtin_ctz(mask))]);
+        }
+    }
 
-        // Generate the deck [2 - 99] and shuffle.
-        const int NUM_CARDS_IN_DECK = 98;
-        int num_cards_in_game = NUM_CARDS_IN_DECK;
-        std::vector<Card> deck(static_cast<size_t>(NUM_CARDS_IN_DECK));
-        std::iota(deck.begin(), deck.end(), 2);
-        std::mt19937 gen32(seed);
-        std::shuffle(deck.begin(), deck.end(), gen32);
+    template <typename StrategyPolicy>
+    static Turn find_turn(TurnEngine turn_engine, const Piles &piles, const Hand &hand, const CardSet &played_cards,
+                          int min_cards_for_turn, int card_reach_distance)
+    {
+        if (turn_engine == TurnEngine::Exhaustive)
+        {
+            return find_best_turn_exhaustive(piles, hand, min_cards_for_turn, card_reach_distance);
+        }
+        return find_best_turn<StrategyPolicy>(piles, hand, played_cards, min_cards_for_turn, card_reach_distance);
+    }
+
+    // Turn engine, strategy and optional cache for one game.
+    template <typename StrategyPolicy>
+    struct TurnFinder
+    {
+        TurnEngine turn_engine;
+        TurnCache *turn_cache;
+        uint64_t num_lookups{0}; // Added to the cache at the end of the game.
+        uint64_t num_hits{0};
 
-        // Deal the hands.
-        const auto num_cards_per_hand = calc_num_cards_per_hand(num_players);
-        for (auto &hand : hands)
+        Turn operator()(const Piles &piles, const Hand &hand, const CardSet &played_cards,
+                        int min_cards_for_turn, int card_reach_distance)
         {
+            // The cache key has no played cards, so a remembering strategy can't use it.
+            if (turn_cache == nullptr || StrategyPolicy::remember_played_cards)
+            {
+                return find_turn<StrategyPolicy>(turn_engine, piles, hand, played_cards, min_cards_for_turn,
+                                                 card_reach_distance);
+            }
+            const unsigned engine = static_cast<unsigned>(StrategyPolicy::strategy) << 1 | static_cast<unsigned>(turn_engine);
+            const auto key = make_turn_cache_key(piles, hand, min_cards_for_turn, card_reach_distance, engine);
+            ++num_lookups;
+            if (const auto turn = turn_cache->find(key))
+            {
+                ++num_hits;
+                return *turn;
+            }
+            const auto turn = find_turn<StrategyPolicy>(turn_engine, piles, hand, played_cards, min_cards_for_turn,
+                                                        card_reach_distance);
+            turn_cache->insert(key, turn);
+            return turn;
+        }
+    };
+
+    template <size_t NUM_PLAYERS>
+    using Hands = std::array<Hand, NUM_PLAYERS>;
+
+    template <size_t NUM_PLAYERS, typename StrategyPolicy>
+    size_t get_strongest_starting_hands_index(const Piles &piles, const Hands<NUM_PLAYERS> &hands,
+                                              int min_cards_for_turn, int card_reach_distance,
+                                              TurnFinder<StrategyPolicy> &turn_finder)
+    {
+        if constexpr (!StrategyPolicy::choose_starting_hand)
+        {
+            return 0;
+        }
+        std::array<Turn, NUM_PLAYERS> turns;
+        for (size_t i = 0; i < NUM_PLAYERS; ++i)
+        {
+            turns[i] = turn_finder(piles, hands[i], CardSet(), min_cards_for_turn, card_reach_distance);
+        }
+        const StrategyTurnCompare<StrategyPolicy> turn_compare{min_cards_for_turn};
+        const auto max_turn_it = std::max_element(turns.begin(), turns.end(), turn_compare);
+        return static_cast<size_t>(max_turn_it - turns.begin());
+    }
+
+    // Deal the hands from a shuffled deck.
+    template <size_t NUM_PLAYERS>
+    void deal_hands(ShuffledDeck &deck, Hands<NUM_PLAYERS> &hands)
+    {
+        TGA_METRICS_TIMER(Metric::DealHands);
+        constexpr auto num_cards_per_hand = calc_num_cards_per_hand(NUM_PLAYERS);
+        for (size_t i = 0; i < NUM_PLAYERS; ++i)
+        {
+            auto &hand = hands[i];
             hand.resize(num_cards_per_hand);
-            std::copy(deck.end() - num_cards_per_hand, deck.end(), hand.begin());
+            for (auto &card : hand)
+            {
+                card = deck.draw();
+            }
             std::sort(hand.begin(), hand.end());
-            deck.erase(deck.end() - num_cards_per_hand, deck.end());
         }
+    }
+
+    enum class TraceGame
+    {
+        No,
+        Yes
+    };
+
+    // play_game() for a fixed number of players and strategy, with printing and tracing compiled in or out.
+    template <size_t NUM_PLAYERS, PrintGame PRINT_GAME, TraceGame TRACE_GAME, typename StrategyPolicy>
+    int play_game_specialized(uint32_t seed, ShuffledDeck deck, ReachSchedule reach_schedule,
+                              TurnEngine turn_engine, TurnCache *turn_cache,
+                              GameTraceWriter *trace_writer, EndgameSolver *endgame_solver)
+    {
+        TurnFinder<StrategyPolicy> turn_finder{turn_engine, turn_cache};
+        Piles piles = {1, 1, 100, 100};
+        Hands<NUM_PLAYERS> hands;
+        CardSet played_cards; // Only kept if the strategy remembers them.
+        int num_cards_in_game = static_cast<int>(deck.size());
+        deal_hands(deck, hands);
 
-        if (print_game == PrintGame::Yes)
+        if constexpr (PRINT_GAME == PrintGame::Yes)
         {
-            std::cout << "seed: " << seed << ", deck: " << to_string(deck) << "\n";
+            deck.shuffle_rest();
+            std::cout << "seed: " << seed << ", deck: " << to_string(deck.get_cards()) << "\n";
         }
 
         const int STARTING_MIN_CARDS_PER_TURN = 2;
         // Get the strongest starting hand
-        auto hands_index = get_strongest_starting_hands_index(piles, hands, STARTING_MIN_CARDS_PER_TURN, card_reach_distance_normal);
+        auto hands_index = get_strongest_starting_hands_index(piles, hands, STARTING_MIN_CARDS_PER_TURN, reach_schedule.card_reach_distances.front(), turn_finder);
 
         // Play the game.
         while (num_cards_in_game > 0)
         {
             auto &hand = hands[hands_index];
+            if constexpr (NUM_PLAYERS == 1)
+            {
+                if (endgame_solver != nullptr && deck.empty())
+                {
+                    assert(num_cards_in_game == static_cast<int>(hand.size()));
+                    num_cards_in_game = endgame_solver->solve(piles, hand);
+                    break;
+                }
+            }
             if (!hand.empty())
             {
                 const int min_cards_for_turn = deck.empty() ? 1 : STARTING_MIN_CARDS_PER_TURN;
-                const int card_reach_distance = deck.empty() ? card_reach_distance_endgame : card_reach_distance_normal;
-                const auto turn = find_best_turn(piles, hand, min_cards_for_turn, card_reach_distance);
-                if (print_game == PrintGame::Yes)
+                const int card_reach_distance = reach_schedule.get(deck.size());
+                const auto turn = turn_finder(piles, hand, played_cards, min_cards_for_turn, card_reach_distance);
+                if constexpr (PRINT_GAME == PrintGame::Yes)
                 {
                     std::cout << to_string(piles) << ", hand: " << hands_index << ", "
                               << to_string(hand) << ", 0x" << std::hex << turn.hand_mask << std::dec
                               << "\n";
                 }
+                if constexpr (TRACE_GAME == TraceGame::Yes)
+                {
+                    trace_writer->add_turn(hands_index, piles, turn);
+                }
                 const auto num_cards_played = get_num_cards_in_hand_mask(turn.hand_mask);
                 num_cards_in_game -= num_cards_played;
                 if (num_cards_played < min_cards_for_turn)
@@ -123,67 +225,512 @@ namespace TheGameAnalyzer
                     break;
                 }
                 piles = turn.piles;
+                if constexpr (StrategyPolicy::remember_played_cards)
+                {
+                    add_played_cards(hand, turn.hand_mask, played_cards);
+                }
                 draw_cards(deck, hand, turn.hand_mask);
             }
             ++hands_index;
-            if (hands_index == hands.size())
+            if (hands_index == NUM_PLAYERS)
             {
                 hands_index = 0;
             }
         }
+        if (turn_cache != nullptr)
+        {
+            turn_cache->add_lookups(turn_finder.num_lookups, turn_finder.num_hits);
+        }
         return num_cards_in_game;
     }
 
+    using PlayGameFn = int (*)(uint32_t, ShuffledDeck, ReachSchedule, TurnEngine, TurnCache *, GameTraceWriter *,
+                               EndgameSolver *);
+
+    // play_game_specialized() for StrategyPolicy, by print_game, trace game and num_players - 1.
+    template <typename StrategyPolicy>
+    constexpr PlayGameFn play_game_fns[][2][MAX_PLAYERS] = {
+        {
+            {
+                play_game_specialized<1, PrintGame::No, TraceGame::No, StrategyPolicy>,
+                play_game_specialized<2, PrintGame::No, TraceGame::No, StrategyPolicy>,
+                play_game_specialized<3, PrintGame::No, TraceGame::No, StrategyPolicy>,
+                play_game_specialized<4, PrintGame::No, TraceGame::No, StrategyPolicy>,
+                play_game_specialized<5, PrintGame::No, TraceGame::No, StrategyPolicy>,
+            },
+            {
+                play_game_specialized<1, PrintGame::No, TraceGame::Yes, StrategyPolicy>,
+                play_game_specialized<2, PrintGame::No, TraceGame::Yes, StrategyPolicy>,
+                play_game_specialized<3, PrintGame::No, TraceGame::Yes, StrategyPolicy>,
+                play_game_specialized<4, PrintGame::No, TraceGame::Yes, StrategyPolicy>,
+                play_game_specialized<5, PrintGame::No, TraceGame::Yes, StrategyPolicy>,
+            },
+        },
+        {
+            {
+                play_game_specialized<1, PrintGame::Yes, TraceGame::No, StrategyPolicy>,
+                play_game_specialized<2, PrintGame::Yes, TraceGame::No, StrategyPolicy>,
+                play_game_specialized<3, PrintGame::Yes, TraceGame::No, StrategyPolicy>,
+                play_game_specialized<4, PrintGame::Yes, TraceGame::No, StrategyPolicy>,
+                play_game_specialized<5, PrintGame::Yes, TraceGame::No, StrategyPolicy>,
+            },
+            {
+                play_game_specialized<1, PrintGame::Yes, TraceGame::Yes, StrategyPolicy>,
+                play_game_specialized<2, PrintGame::Yes, TraceGame::Yes, StrategyPolicy>,
+                play_game_specialized<3, PrintGame::Yes, TraceGame::Yes, StrategyPolicy>,
+                play_game_specialized<4, PrintGame::Yes, TraceGame::Yes, StrategyPolicy>,
+                play_game_specialized<5, PrintGame::Yes, TraceGame::Yes, StrategyPolicy>,
+            },
+        },
+    };
+
+    // Play a game from an already shuffled deck. (seed is just for printing.)
+    //
+    // \param trace_writer If not null, add each turn to it.
+    // \param endgame_solver If not null, play a 1 player endgame with it.
+    static int play_dealt_game(uint32_t seed, const ShuffledDeck &deck, int num_players,
+                               const ReachSchedule &reach_schedule, PrintGame print_game, TurnEngine turn_engine,
+                               TurnCache *turn_cache, Strategy strategy, GameTraceWriter *trace_writer = nullptr,
+                               EndgameSolver *endgame_solver = nullptr)
+    {
+        assert(num_players >= MIN_PLAYERS && "Not enough players");
+        assert(num_players <= MAX_PLAYERS && "Too many players");
+        for ([[maybe_unused]] const int card_reach_distance : reach_schedule.card_reach_distances)
+        {
+            assert(card_reach_distance >= MIN_CARD_REACH_DISTANCE && "Bad card reach distance");
+            assert(card_reach_distance <= MAX_CARD_REACH_DISTANCE && "Bad card reach distance");
+        }
+
+        const auto trace_game = trace_writer != nullptr ? TraceGame::Yes : TraceGame::No;
+        const auto play_game_fn = visit_strategy(strategy, [&](auto strategy_policy)
+                                                 { return play_game_fns<decltype(strategy_policy)>
+                                                       [static_cast<size_t>(print_game)][static_cast<size_t>(trace_game)][num_players - 1]; });
+        return play_game_fn(seed, deck, reach_schedule, turn_engine, turn_cache, trace_writer, endgame_solver);
+    }
+
+    int play_game(uint32_t seed, int num_players, int card_reach_distance_normal,
+                  int card_reach_distance_endgame, PrintGame print_game,
+                  TurnEngine turn_engine, TurnCache *turn_cache, DeckRng deck_rng, Strategy strategy)
+    {
+        return play_dealt_game(seed, ShuffledDeck(seed, deck_rng), num_players,
+                               make_reach_schedule(card_reach_distance_normal, card_reach_distance_endgame), print_game,
+                               turn_engine, turn_cache, strategy);
+    }
+
+    int play_game(const ShuffledDeck &deck, int num_players, int card_reach_distance_normal,
+                  int card_reach_distance_endgame, TurnEngine turn_engine, TurnCache *turn_cache,
+                  Strategy strategy, EndgameSolver *endgame_solver)
+    {
+        return play_dealt_game(0, deck, num_players,
+                               make_reach_schedule(card_reach_distance_normal, card_reach_distance_endgame),
+                               PrintGame::No, turn_engine, turn_cache, strategy, nullptr, endgame_solver);
+    }
+
+    int play_game(const ShuffledDeck &deck, int num_players, const ReachSchedule &reach_schedule, Strategy strategy)
+    {
+        return play_dealt_game(0, deck, num_players, reach_schedule, PrintGame::No, TurnEngine::Greedy, nullptr,
+                               strategy);
+    }
+
+    // One game shared by a range of configurations, see play_game_forked().
+    template <size_t NUM_PLAYERS>
+    struct ForkedGame
+    {
+        ShuffledDeck deck;
+        Piles piles = {1, 1, 100, 100};
+        Hands<NUM_PLAYERS> hands;
+        size_t hands_index{0};
+        int num_cards_in_game{0};
+        size_t configs_first{0}; // Range of config_indexes playing this game.
+        size_t configs_last{0};
+    };
+
+    // Configurations sharing one game, split up by the turn each one chooses.
+    class ConfigGroups
+    {
+    public:
+        explicit ConfigGroups(size_t num_configs)
+            : config_indexes_(num_configs), groups_(num_configs), scratch_(num_configs)
+        {
+            std::iota(config_indexes_.begin(), config_indexes_.end(), 0);
+        }
+
+        size_t operator[](size_t i) const { return config_indexes_[i]; }
+
+        // Set the group of the i-th configuration (groups are numbered from 0).
+        void set_group(size_t i, size_t group) { groups_[i] = group; }
+
+        // Stable sort [first, last) by group.
+        //
+        // \param num_groups Number of groups in [first, last).
+        // \param groups_first [out] Start of each group, and last at the end.
+        template <typename GroupsFirst>
+        void partition(size_t first, size_t last, size_t num_groups, GroupsFirst &groups_first)
+        {
+            groups_first.assign(num_groups + 1, 0);
+            for (size_t i = first; i < last; ++i)
+            {
+                ++groups_first[groups_[i] + 1];
+            }
+            groups_first[0] = first;
+            std::partial_sum(groups_first.begin(), groups_first.end(), groups_first.begin());
+            auto next = groups_first;
+            for (size_t i = first; i < last; ++i)
+            {
+                scratch_[next[groups_[i]]++] = config_indexes_[i];
+            }
+            std::copy(scratch_.begin() + first, scratch_.begin() + last, config_indexes_.begin() + first);
+        }
+
+    private:
+        std::vector<size_t> config_indexes_; // Configurations of each game are a contiguous range.
+        std::vector<size_t> groups_;         // Group of each position in config_indexes_.
+        std::vector<size_t> scratch_;
+    };
+
+    template <size_t NUM_PLAYERS>
+    void play_game_forked_specialized(const ShuffledDeck &deck, const CardReachDistances *configs,
+                                      size_t num_configs, TurnEngine turn_engine, int *num_cards_remaining)
+    {
+        const int STARTING_MIN_CARDS_PER_TURN = 2;
+        TurnFinder<BasicStrategy> turn_finder{turn_engine, nullptr};
+        ConfigGroups config_groups(num_configs);
+        std::vector<size_t> groups_first;
+
+        // Games waiting to be played. (A stack on the heap: games are big and
+        // there can be as many as there are configurations.)
+        std::vector<ForkedGame<NUM_PLAYERS>> games(1);
+        auto &trunk = games.front();
+        trunk.deck = deck;
+        trunk.num_cards_in_game = static_cast<int>(deck.size());
+        deal_hands(trunk.deck, trunk.hands);
+        trunk.configs_first = 0;
+        trunk.configs_last = num_configs;
+
+        // The starting hand depends on the normal reach distance.
+        {
+            std::array<int, MAX_CARD_REACH_DISTANCE + 1> hands_index_of_reach;
+            hands_index_of_reach.fill(-1);
+            for (size_t i = 0; i < num_configs; ++i)
+            {
+                auto &hands_index = hands_index_of_reach[configs[config_groups[i]].normal];
+                if (hands_index < 0)
+                {
+                    hands_index = static_cast<int>(get_strongest_starting_hands_index(
+                        trunk.piles, trunk.hands, STARTING_MIN_CARDS_PER_TURN,
+                        configs[config_groups[i]].normal, turn_finder));
+                }
+                config_groups.set_group(i, static_cast<size_t>(hands_index));
+            }
+            config_groups.partition(0, num_configs, NUM_PLAYERS, groups_first);
+            for (size_t hands_index = 0; hands_index < NUM_PLAYERS; ++hands_index)
+            {
+                if (groups_first[hands_index] == groups_first[hands_index + 1])
+                {
+                    continue;
+                }
+                auto game = games.front();
+                game.hands_index = hands_index;
+                game.configs_first = groups_first[hands_index];
+                game.configs_last = groups_first[hands_index + 1];
+                games.push_back(game);
+            }
+            games.erase(games.begin());
+        }
+
+        FixedVector<Turn, MAX_CARD_REACH_DISTANCE + 1> turns;
+        std::array<int, MAX_CARD_REACH_DISTANCE + 1> turns_index_of_reach;
+        while (!games.empty())
+        {
+            ForkedGame<NUM_PLAYERS> game = games.back();
+            games.pop_back();
+            while (true)
+            {
+                if (game.num_cards_in_game <= 0)
+                {
+                    break;
+                }
+                auto &hand = game.hands[game.hands_index];
+                if (hand.empty())
+                {
+                    game.hands_index = game.hands_index + 1 == NUM_PLAYERS ? 0 : game.hands_index + 1;
+                    continue;
+                }
+                const int min_cards_for_turn = game.deck.empty() ? 1 : STARTING_MIN_CARDS_PER_TURN;
+
+                // Turn for each distinct reach distance, and configurations grouped by turn.
+                turns.clear();
+                turns_index_of_reach.fill(-1);
+                for (size_t i = game.configs_first; i < game.configs_last; ++i)
+                {
+                    const auto &config = configs[config_groups[i]];
+                    const int card_reach_distance = game.deck.empty() ? config.endgame : config.normal;
+                    auto &turns_index = turns_index_of_reach[card_reach_distance];
+                    if (turns_index < 0)
+                    {
+                        const auto turn = turn_finder(game.piles, hand, CardSet(), min_cards_for_turn,
+                                                      card_reach_distance);
+                        const auto it = std::find_if(turns.begin(), turns.end(), [&](const Turn &t)
+                                                     { return t.hand_mask == turn.hand_mask && t.piles == turn.piles; });
+                        turns_index = static_cast<int>(it - turns.begin());
+                        if (it == turns.end())
+                        {
+                            turns.push_back(turn);
+                        }
+                    }
+                    config_groups.set_group(i, static_cast<size_t>(turns_index));
+                }
+                if (turns.size() > 1)
+                {
+                    // Fork: this game carries on with the first turn, the others are copies.
+                    config_groups.partition(game.configs_first, game.configs_last, turns.size(), groups_first);
+                    for (size_t turns_index = 1; turns_index < turns.size(); ++turns_index)
+                    {
+                        games.push_back(game);
+                        auto &fork = games.back();
+                        fork.configs_first = groups_first[turns_index];
+                        fork.configs_last = groups_first[turns_index + 1];
+                        const auto &turn = turns[turns_index];
+                        const auto num_cards_played = get_num_cards_in_hand_mask(turn.hand_mask);
+                        fork.num_cards_in_game -= num_cards_played;
+                        if (num_cards_played < min_cards_for_turn)
+                        {
+                            for (size_t i = fork.configs_first; i < fork.configs_last; ++i)
+                            {
+                                num_cards_remaining[config_groups[i]] = fork.num_cards_in_game;
+                            }
+                            games.pop_back();
+                            continue;
+                        }
+                        fork.piles = turn.piles;
+                        draw_cards(fork.deck, fork.hands[fork.hands_index], turn.hand_mask);
+                        fork.hands_index = fork.hands_index + 1 == NUM_PLAYERS ? 0 : fork.hands_index + 1;
+                    }
+                    game.configs_last = groups_first[1];
+                }
+
+                const auto &turn = turns.front();
+                const auto num_cards_played = get_num_cards_in_hand_mask(turn.hand_mask);
+                game.num_cards_in_game -= num_cards_played;
+                if (num_cards_played < min_cards_for_turn)
+                {
+                    break;
+                }
+                game.piles = turn.piles;
+                draw_cards(game.deck, hand, turn.hand_mask);
+                game.hands_index = game.hands_index + 1 == NUM_PLAYERS ? 0 : game.hands_index + 1;
+            }
+            for (size_t i = game.configs_first; i < game.configs_last; ++i)
+            {
+                num_cards_remaining[config_groups[i]] = game.num_cards_in_game;
+            }
+        }
+    }
+
+    void play_game_forked(const ShuffledDeck &deck, int num_players, const CardReachDistances *configs,
+                          size_t num_configs, TurnEngine turn_engine, int *num_cards_remaining)
+    {
+        assert(num_players >= MIN_PLAYERS && "Not enough players");
+        assert(num_players <= MAX_PLAYERS && "Too many players");
+        for (size_t i = 0; i < num_configs; ++i)
+        {
+            assert(configs[i].normal >= MIN_CARD_REACH_DISTANCE && configs[i].normal <= MAX_CARD_REACH_DISTANCE);
+            assert(configs[i].endgame >= MIN_CARD_REACH_DISTANCE && configs[i].endgame <= MAX_CARD_REACH_DISTANCE);
+        }
+        if (num_configs == 0)
+        {
+            return;
+        }
+
+        using PlayGameForkedFn = void (*)(const ShuffledDeck &, const CardReachDistances *, size_t, TurnEngine, int *);
+        static constexpr PlayGameForkedFn play_game_forked_fns[MAX_PLAYERS] = {
+            play_game_forked_specialized<1>,
+            play_game_forked_specialized<2>,
+            play_game_forked_specialized<3>,
+            play_game_forked_specialized<4>,
+            play_game_forked_specialized<5>,
+        };
+        play_game_forked_fns[num_players - 1](deck, configs, num_configs, turn_engine, num_cards_remaining);
+    }
+
     std::string to_string(const TheGamesResults &tgr)
     {
         std::ostringstream oss;
         oss << "{ \"excellent_percent\":" << tgr.excellent_percent
             << ", \"beat_the_game_percent\": " << tgr.beat_the_game_percent
             << ", \"cards_left_average\": " << tgr.cards_left_average
-            << ", \"cards_left_stddev\": " << tgr.cards_left_stddev
-            << "}";
+            << ", \"cards_left_stddev\": " << tgr.cards_left_stddev;
+        if (tgr.turn_cache_stats)
+        {
+            const auto &stats = *tgr.turn_cache_stats;
+            const double hit_percent = stats.lookups > 0 ? 100.0 * stats.hits / stats.lookups : 0.0;
+            oss << ", \"turn_cache_lookups\": " << stats.lookups
+                << ", \"turn_cache_hit_percent\": " << hit_percent
+                << ", \"turn_cache_bytes\": " << stats.bytes;
+        }
+        if (tgr.metrics)
+        {
+            oss << ", \"metrics\": " << to_json(*tgr.metrics);
+        }
+        oss << "}";
         return oss.str();
     }
 
-    TheGamesResults calculate_games_stats(const std::vector<int> &num_cards_played)
+    void GamesStats::merge(const GamesStats &other)
     {
-        assert(num_cards_played.size() > 0);
+        for (size_t i = 0; i < num_games.size(); ++i)
+        {
+            num_games[i] += other.num_games[i];
+        }
+    }
+
+    TheGamesResults calculate_games_stats(const GamesStats &games_stats)
+    {
+        // Integer sums, so the result doesn't depend on the order the games were added.
+        uint64_t num_games_total = 0;
+        uint64_t num_excellent = 0;
+        uint64_t sum = 0;
+        unsigned __int128 sum_of_squares = 0;
+        for (uint64_t i = 0; i < games_stats.num_games.size(); ++i)
+        {
+            const uint64_t n = games_stats.num_games[i];
+            num_games_total += n;
+            num_excellent += i < 10 ? n : 0;
+            sum += i * n;
+            sum_of_squares += static_cast<unsigned __int128>(i * i) * n;
+        }
+        assert(num_games_total > 0);
         TheGamesResults results;
-        const double num_games = static_cast<double>(num_cards_played.size());
-        results.excellent_percent = std::count_if(num_cards_played.begin(), num_cards_played.end(), [](auto i)
-                                                  { return i < 10; }) /
-                                    num_games * 100.0;
-        results.beat_the_game_percent = std::count_if(num_cards_played.begin(), num_cards_played.end(), [](auto i)
-                                                      { return i == 0; }) /
-                                        num_games * 100.0;
-        results.cards_left_average = std::accumulate(num_cards_played.begin(), num_cards_played.end(), 0) / num_games;
-        results.cards_left_stddev = std::sqrt(std::accumulate(num_cards_played.begin(), num_cards_played.end(), 0.0, [&](double d, int i)
-                                                              { return d + std::pow(static_cast<double>(i) - results.cards_left_average, 2); }) /
-                                              num_games);
+        const double num_games = static_cast<double>(num_games_total);
+        results.excellent_percent = static_cast<double>(num_excellent) / num_games * 100.0;
+        results.beat_the_game_percent = static_cast<double>(games_stats.num_games[0]) / num_games * 100.0;
+        results.cards_left_average = static_cast<double>(sum) / num_games;
+        // n * sum((x - mean)^2) = n * sum(x^2) - sum(x)^2, exactly.
+        const unsigned __int128 n_squared_variance = num_games_total * sum_of_squares -
+                                                     static_cast<unsigned __int128>(sum) * sum;
+        results.cards_left_stddev = std::sqrt(static_cast<double>(n_squared_variance) / num_games / num_games);
         return results;
     }
 
+    TheGamesResults calculate_games_stats(const std::vector<int> &num_cards_played)
+    {
+        GamesStats games_stats;
+        for (const auto num_cards : num_cards_played)
+        {
+            games_stats.add(num_cards);
+        }
+        return calculate_games_stats(games_stats);
+    }
+
     TheGamesResults play_games(int num_players, int card_reach_distance_normal, int card_reach_distance_endgame,
-                               int num_trials, bool do_parallel)
+                               uint64_t num_trials, bool do_parallel, TurnEngine turn_engine,
+                               size_t turn_cache_bytes, DeckRng deck_rng,
+                               const DeckCorpus *deck_corpus, SchedulerOptions scheduler_options,
+                               GameTraceFile *game_trace, Strategy strategy)
     {
         assert(num_trials >= MIN_TRIALS);
         assert(num_trials <= MAX_TRIALS);
-        std::vector<size_t> seeds(static_cast<size_t>(num_trials));
-        std::iota(seeds.begin(), seeds.end(), 0);
-        std::vector<int> num_cards_played(static_cast<size_t>(num_trials));
+        assert(deck_corpus == nullptr || num_trials <= deck_corpus->size());
         const auto print_game = num_trials == 1 ? PrintGame::Yes : PrintGame::No;
-        // Blah. Is this any better? https://stackoverflow.com/questions/52975114/different-execution-policies-at-runtime
-        if (do_parallel)
+        std::unique_ptr<TurnCache> turn_cache_owner;
+        if (turn_cache_bytes > 0)
+        {
+            turn_cache_owner = std::make_unique<TurnCache>(turn_cache_bytes);
+        }
+        TurnCache *const turn_cache = turn_cache_owner.get();
+        const auto reach_schedule = make_reach_schedule(card_reach_distance_normal, card_reach_distance_endgame);
+
+        // Seeds [0, num_trials) are split into at most MAX_NUM_CHUNKS chunks
+        // for the scheduler, and each thread adds to its own stats.
+        const uint64_t MIN_CHUNK_SIZE = 64;
+        const uint64_t MAX_NUM_CHUNKS = 4096;
+        const uint64_t num_chunks = std::min(MAX_NUM_CHUNKS, (num_trials + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE);
+        if (!do_parallel)
+        {
+            scheduler_options = SchedulerOptions{1, false};
+        }
+        struct alignas(64) ThreadStats
         {
-            std::transform(std::execution::par, seeds.begin(), seeds.end(), num_cards_played.begin(), [=](auto seed)
-                           { return play_game(seed, num_players, card_reach_distance_normal, card_reach_distance_endgame, print_game); });
+            GamesStats games_stats;
+            MetricsStats metrics;
+        };
+        std::vector<ThreadStats> threads_stats(get_num_threads(scheduler_options));
+        std::vector<std::unique_ptr<GameTraceWriter>> trace_writers(threads_stats.size());
+        if (game_trace != nullptr)
+        {
+            for (auto &trace_writer : trace_writers)
+            {
+                trace_writer = std::make_unique<GameTraceWriter>(*game_trace);
+            }
         }
-        else
+        auto play_chunk = [&](uint64_t chunk_index, unsigned thread_index)
         {
-            std::transform(std::execution::seq, seeds.begin(), seeds.end(), num_cards_played.begin(), [=](auto seed)
-                           { return play_game(seed, num_players, card_reach_distance_normal, card_reach_distance_endgame, print_game); });
+            const uint64_t first_seed = num_trials * chunk_index / num_chunks;
+            const uint64_t last_seed = num_trials * (chunk_index + 1) / num_chunks;
+            GamesStats &games_stats = threads_stats[thread_index].games_stats;
+            take_thread_metrics();
+            if (game_trace != nullptr)
+            {
+                GameTraceWriter *const trace_writer = trace_writers[thread_index].get();
+                for (uint64_t seed = first_seed; seed < last_seed; ++seed)
+                {
+                    const auto seed32 = static_cast<uint32_t>(seed);
+                    const ShuffledDeck deck = deck_corpus != nullptr ? deck_corpus->get_deck(seed)
+                                                                     : ShuffledDeck(seed32, deck_rng);
+                    trace_writer->begin_game(seed32, deck_corpus != nullptr ? std::nullopt : std::optional<DeckRng>(deck_rng),
+                                             deck, num_players, card_reach_distance_normal, card_reach_distance_endgame);
+                    const int num_cards_remaining = play_dealt_game(seed32, deck, num_players, reach_schedule,
+                                                                    print_game, turn_engine,
+                                                                    turn_cache, strategy, trace_writer);
+                    trace_writer->end_game(num_cards_remaining);
+                    games_stats.add(num_cards_remaining);
+                }
+            }
+            else if (deck_corpus != nullptr)
+            {
+                for (uint64_t seed = first_seed; seed < last_seed; ++seed)
+                {
+                    games_stats.add(play_dealt_game(static_cast<uint32_t>(seed), deck_corpus->get_deck(seed),
+                                                    num_players, reach_schedule, print_game, turn_engine, turn_cache,
+                                                    strategy));
+                }
+            }
+            else
+            {
+                for (uint64_t seed = first_seed; seed < last_seed; ++seed)
+                {
+                    games_stats.add(play_game(static_cast<uint32_t>(seed), num_players, card_reach_distance_normal,
+                                              card_reach_distance_endgame, print_game, turn_engine, turn_cache, deck_rng,
+                                              strategy));
+                }
+            }
+            if (METRICS_ENABLED)
+            {
+                threads_stats[thread_index].metrics.merge(take_thread_metrics());
+            }
+        };
+        parallel_for_chunks(num_chunks, scheduler_options, play_chunk);
+        trace_writers.clear();
+        GamesStats games_stats;
+        MetricsStats metrics;
+        for (const auto &thread_stats : threads_stats)
+        {
+            games_stats.merge(thread_stats.games_stats);
+            if (METRICS_ENABLED)
+            {
+                metrics.merge(thread_stats.metrics);
+            }
+        }
+        auto results = calculate_games_stats(games_stats);
+        if (turn_cache)
+        {
+            results.turn_cache_stats = turn_cache->get_stats();
         }
-        return calculate_games_stats(num_cards_played);
+        if (METRICS_ENABLED)
+        {
+            results.metrics = metrics;
+        }
+        return results;
     }
 
 } // namespace TheGameAnalyzer
\ No newline at end of file
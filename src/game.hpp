@@ -1,19 +1,81 @@
 #pragma once
 
+#include "deck.hpp"
+#include "game_trace.hpp"
+#include "metrics.hpp"
+#include "scheduler.hpp"
+#include "strategy.hpp"
+#include "turn_cache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <cstdint>
+#include <optional>
 #include <string>
 #include <vector>
 
 namespace TheGameAnalyzer
 {
+    class EndgameSolver;
+
     const int MIN_PLAYERS = 1;
     const int MAX_PLAYERS = 5;
 
     const int MIN_CARD_REACH_DISTANCE = 0;
     const int MAX_CARD_REACH_DISTANCE = 20;
 
-    const int MIN_TRIALS = 1;
-    const int MAX_TRIALS = 10'000;
+    // Stages of the game for a ReachSchedule: while the deck has at least
+    // 64 cards, at least 32, at least 1, and once it's empty (the endgame).
+    const size_t NUM_REACH_STAGES = 4;
+    const size_t REACH_STAGE_NUM_CARDS = 32;
+
+    // Reach distance for each stage of the game, by cards left in the deck.
+    struct ReachSchedule
+    {
+        std::array<int, NUM_REACH_STAGES> card_reach_distances{};
+
+        int get(size_t num_cards_in_deck) const
+        {
+            if (num_cards_in_deck == 0)
+            {
+                return card_reach_distances.back();
+            }
+            const size_t stage = NUM_REACH_STAGES - 2 - std::min(NUM_REACH_STAGES - 2, num_cards_in_deck / REACH_STAGE_NUM_CARDS);
+            return card_reach_distances[stage];
+        }
+    };
+
+    // The normal reach distance until the deck is empty, then the endgame one.
+    inline ReachSchedule make_reach_schedule(int card_reach_distance_normal, int card_reach_distance_endgame)
+    {
+        return {{card_reach_distance_normal, card_reach_distance_normal, card_reach_distance_normal,
+                 card_reach_distance_endgame}};
+    }
+
+    const uint64_t MIN_TRIALS = 1;
+    const uint64_t MAX_TRIALS = uint64_t{1} << 32; // One per seed.
+
+    // Number of cards in each hand.
+    constexpr size_t calc_num_cards_per_hand(size_t num_players)
+    {
+        switch (num_players)
+        {
+        case 1:
+            return 8;
+        case 2:
+            return 7;
+        case 3:
+        case 4:
+        case 5:
+            return 6;
+        }
+        assert(false);
+        return 0;
+    }
+
+    // Replace the cards in hand_mask with cards drawn from the back of deck, keeping hand sorted.
+    void draw_cards(Deck &deck, Hand &hand, HandMask hand_mask);
 
     enum class PrintGame
     {
@@ -21,6 +83,13 @@ namespace TheGameAnalyzer
         Yes
     };
 
+    // How each turn is chosen.
+    enum class TurnEngine
+    {
+        Greedy,     // find_best_turn()
+        Exhaustive, // find_best_turn_exhaustive()
+    };
+
     // Play the game.
     //
     // \param seed Seed for random deck shuffle.
@@ -28,9 +97,61 @@ namespace TheGameAnalyzer
     // \param card_reach_distance_normal How much to reach for playing another card (before the endgame).
     // \param card_reach_distance_endgame How much to reach for playing another card during the endgame.
     // \param do_print_game If true print the game to stdout.
+    // \param turn_engine How each turn is chosen.
+    // \param turn_cache If not null, look up and store turns here.
+    // \param deck_rng How the deck is shuffled.
+    // \param strategy Heuristic for the greedy turn engine and the starting hand. (The exhaustive
+    //                 turn engine always orders turns like Strategy::Basic.)
     // \return number of cards remaining.
     int play_game(uint32_t seed, int num_players, int card_reach_distance_normal,
-                  int card_reach_distance_endgame, PrintGame print_game);
+                  int card_reach_distance_endgame, PrintGame print_game,
+                  TurnEngine turn_engine = TurnEngine::Greedy,
+                  TurnCache *turn_cache = nullptr,
+                  DeckRng deck_rng = DeckRng::StdCompat,
+                  Strategy strategy = Strategy::Basic);
+
+    // Play the game from an already shuffled deck, without printing.
+    //
+    // \param deck Shuffled deck, before the hands are dealt.
+    // \param endgame_solver If not null and num_players is 1, play the endgame (once the deck is
+    //                       empty) perfectly with it, see endgame.hpp.
+    // See play_game() above for the other parameters.
+    int play_game(const ShuffledDeck &deck, int num_players, int card_reach_distance_normal,
+                  int card_reach_distance_endgame, TurnEngine turn_engine = TurnEngine::Greedy,
+                  TurnCache *turn_cache = nullptr, Strategy strategy = Strategy::Basic,
+                  EndgameSolver *endgame_solver = nullptr);
+
+    // Play the game from an already shuffled deck with the greedy turn
+    // engine, reaching by the stage of the game. (The strongest starting
+    // hand is found with the first stage's reach distance.)
+    //
+    // See play_game() above for the other parameters.
+    int play_game(const ShuffledDeck &deck, int num_players, const ReachSchedule &reach_schedule,
+                  Strategy strategy = Strategy::Basic);
+
+    // Reach distances of one configuration for play_game_forked().
+    struct CardReachDistances
+    {
+        int normal{0};  // Before the endgame.
+        int endgame{0}; // During the endgame.
+    };
+
+    // Play one deck for several reach distance configurations at once. Same
+    // results as play_game() (with Strategy::Basic) for each configuration.
+    //
+    // The configurations share one game until they choose different turns,
+    // and only then is the game copied, once for each different turn. The
+    // endgame reach distance doesn't matter until the deck is empty, and most
+    // turns are the same for every reach distance.
+    //
+    // \param deck Shuffled deck, before the hands are dealt.
+    // \param num_players Number of players in the game (1-5).
+    // \param configs Reach distances for each configuration.
+    // \param num_configs Number of configurations.
+    // \param turn_engine How each turn is chosen.
+    // \param num_cards_remaining [out] Number of cards remaining for each configuration.
+    void play_game_forked(const ShuffledDeck &deck, int num_players, const CardReachDistances *configs,
+                          size_t num_configs, TurnEngine turn_engine, int *num_cards_remaining);
 
     struct TheGamesResults
     {
@@ -38,11 +159,25 @@ namespace TheGameAnalyzer
         double beat_the_game_percent = 0.0f; // Percentage of games that beat the game.
         double cards_left_average = 0.0f;    // Average number of cards remaining.
         double cards_left_stddev = 0.0f;     // Standard deviation of cards remaining.
+        std::optional<TurnCacheStats> turn_cache_stats; // If a turn cache was used.
+        std::optional<MetricsStats> metrics;            // If built with TGA_METRICS.
     };
 
     std::string to_string(const TheGamesResults &the_games_results);
 
+    // Number of games ending with each number of cards remaining.
+    //
+    // Merging gives the same counts in any order, so the results don't
+    // depend on how the games were split between threads.
+    struct GamesStats
+    {
+        std::array<uint64_t, NUM_CARDS_IN_DECK + 1> num_games{};
+        void add(int num_cards_remaining) { ++num_games[static_cast<size_t>(num_cards_remaining)]; }
+        void merge(const GamesStats &other);
+    };
+
     // Calculate results from several games.
+    TheGamesResults calculate_games_stats(const GamesStats &games_stats);
     TheGamesResults calculate_games_stats(const std::vector<int> &num_cards_played);
 
     // Play several trials of the game.
@@ -50,11 +185,26 @@ namespace TheGameAnalyzer
     // \param num_players Number of players in the game (1-5).
     // \param card_reach_distance How much to reach for playing another card (before the endgame).
     // \param card_reach_distance_endgame How much to reach for playing another card during the endgame.
-    // \param num_trials Number of trials to run (1-10,000). Note if num_trials is 1,
+    // \param num_trials Number of trials to run (1-2^32), seeds [0, num_trials). Note if num_trials is 1,
     //                    print_game is set to true, otherwise false.
-    // \param do_parallel If true run the trials in parallel.
+    // \param do_parallel If true run the trials in parallel, see scheduler_options.
+    // \param turn_engine How each turn is chosen.
+    // \param turn_cache_bytes If not 0, share a turn cache of this size across all trials.
+    // \param deck_rng How the decks are shuffled.
+    // \param deck_corpus If not null, trial i plays deck i of the corpus instead of shuffling (and
+    //                    deck_rng is ignored). num_trials must be at most its size.
+    // \param scheduler_options Threads to run the trials on if do_parallel.
+    // \param game_trace If not null, record every game to it.
+    // \param strategy Heuristic, see play_game().
     // \return Statistics for playing several trials of the game.
     TheGamesResults play_games(int num_players, int card_reach_distance, int card_reach_distance_endgame,
-                               int num_trials, bool do_parallel);
+                               uint64_t num_trials, bool do_parallel,
+                               TurnEngine turn_engine = TurnEngine::Greedy,
+                               size_t turn_cache_bytes = 0,
+                               DeckRng deck_rng = DeckRng::StdCompat,
+                               const DeckCorpus *deck_corpus = nullptr,
+                               SchedulerOptions scheduler_options = {},
+                               GameTraceFile *game_trace = nullptr,
+                               Strategy strategy = Strategy::Basic);
 
 } // namespace TheGameAnalyzer
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include "game_trace.hpp"
+
+#include "game.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+namespace TheGameAnalyzer
+{
+    namespace
+    {
+        const char TRACE_MAGIC[] = "TGATRC1\n";
+        const size_t TRACE_MAGIC_SIZE = sizeof(TRACE_MAGIC) - 1;
+        const uint8_t END_OF_GAME = 0xff;
+
+        enum DeckSource : uint8_t
+        {
+            DECK_STD_COMPAT = 0,
+            DECK_XOSHIRO256 = 1,
+            DECK_CARDS = 2,
+        };
+
+        uint8_t read_byte(std::istream &is)
+        {
+            const int c = is.get();
+            if (c == std::char_traits<char>::eof())
+            {
+                throw std::runtime_error("Trace ends in the middle of a game");
+            }
+            return static_cast<uint8_t>(c);
+        }
+
+        uint32_t read_seed(std::istream &is)
+        {
+            uint64_t seed = 0;
+            for (int shift = 0; shift < 35; shift += 7)
+            {
+                const uint8_t b = read_byte(is);
+                seed |= static_cast<uint64_t>(b & 0x7f) << shift;
+                if ((b & 0x80) == 0)
+                {
+                    return static_cast<uint32_t>(seed);
+                }
+            }
+            throw std::runtime_error("Bad seed in trace");
+        }
+    } // namespace
+
+    GameTraceFile::GameTraceFile(const std::string &path)
+        : path_(path), file_(std::fopen(path.c_str(), "wb"))
+    {
+        if (file_ == nullptr)
+        {
+            throw std::runtime_error("Can't write trace: " + path);
+        }
+        if (std::fwrite(TRACE_MAGIC, 1, TRACE_MAGIC_SIZE, file_) != TRACE_MAGIC_SIZE)
+        {
+            std::fclose(file_);
+            throw std::runtime_error("Can't write trace: " + path);
+        }
+    }
+
+    GameTraceFile::~GameTraceFile()
+    {
+        if (file_ != nullptr)
+        {
+            std::fclose(file_);
+        }
+    }
+
+    void GameTraceFile::write(const std::vector<uint8_t> &bytes)
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        assert(file_ != nullptr && "Write after close()");
+        if (std::fwrite(bytes.data(), 1, bytes.size(), file_) != bytes.size())
+        {
+            is_write_failed_ = true;
+        }
+    }
+
+    void GameTraceFile::close()
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        assert(file_ != nullptr && "Closed twice");
+        const bool is_close_failed = std::fclose(file_) != 0;
+        file_ = nullptr;
+        if (is_write_failed_ || is_close_failed)
+        {
+            throw std::runtime_error("Can't write trace: " + path_);
+        }
+    }
+
+    void GameTraceWriter::begin_game(uint32_t seed, std::optional<DeckRng> deck_rng, const ShuffledDeck &deck,
+                                     int num_players, int card_reach_distance_normal,
+                                     int card_reach_distance_endgame)
+    {
+        uint32_t s = seed;
+        while (s >= 0x80)
+        {
+            buffer_.push_back(static_cast<uint8_t>(s | 0x80));
+            s >>= 7;
+        }
+        buffer_.push_back(static_cast<uint8_t>(s));
+        if (deck_rng)
+        {
+            buffer_.push_back(*deck_rng == DeckRng::StdCompat ? DECK_STD_COMPAT : DECK_XOSHIRO256);
+        }
+        else
+        {
+            buffer_.push_back(DECK_CARDS);
+            ShuffledDeck cards = deck;
+            cards.shuffle_rest();
+            assert(cards.size() == NUM_CARDS_IN_DECK);
+            for (const auto c : cards.get_cards())
+            {
+                buffer_.push_back(static_cast<uint8_t>(c));
+            }
+        }
+        buffer_.push_back(static_cast<uint8_t>(num_players));
+        buffer_.push_back(static_cast<uint8_t>(card_reach_distance_normal));
+        buffer_.push_back(static_cast<uint8_t>(card_reach_distance_endgame));
+    }
+
+    void GameTraceWriter::end_game(int num_cards_remaining)
+    {
+        buffer_.push_back(END_OF_GAME);
+        buffer_.push_back(static_cast<uint8_t>(num_cards_remaining));
+        if (buffer_.size() >= FLUSH_BYTES)
+        {
+            flush();
+        }
+    }
+
+    void GameTraceWriter::flush()
+    {
+        if (!buffer_.empty())
+        {
+            file_.write(buffer_);
+            buffer_.clear();
+        }
+    }
+
+    void decode_game_trace(std::istream &is, std::ostream &os)
+    {
+        char magic[TRACE_MAGIC_SIZE];
+        if (!is.read(magic, TRACE_MAGIC_SIZE) || std::memcmp(magic, TRACE_MAGIC, TRACE_MAGIC_SIZE) != 0)
+        {
+            throw std::runtime_error("Not a trace file");
+        }
+        while (is.peek() != std::char_traits<char>::eof())
+        {
+            const uint32_t seed = read_seed(is);
+            const uint8_t deck_source = read_byte(is);
+            Deck deck;
+            if (deck_source == DECK_STD_COMPAT || deck_source == DECK_XOSHIRO256)
+            {
+                ShuffledDeck shuffled_deck(seed, deck_source == DECK_STD_COMPAT ? DeckRng::StdCompat : DeckRng::Xoshiro256);
+                shuffled_deck.shuffle_rest();
+                deck = shuffled_deck.get_cards();
+            }
+            else if (deck_source == DECK_CARDS)
+            {
+                deck.resize(NUM_CARDS_IN_DECK);
+                for (auto &c : deck)
+                {
+                    c = read_byte(is);
+                }
+            }
+            else
+            {
+                throw std::runtime_error("Bad deck in trace");
+            }
+            const int num_players = read_byte(is);
+            read_byte(is); // Reach distances, not needed to replay.
+            read_byte(is);
+            if (num_players < MIN_PLAYERS || num_players > MAX_PLAYERS)
+            {
+                throw std::runtime_error("Bad number of players in trace");
+            }
+
+            // Deal as play_game() does.
+            std::vector<Hand> hands(static_cast<size_t>(num_players));
+            const size_t num_cards_per_hand = calc_num_cards_per_hand(static_cast<size_t>(num_players));
+            for (auto &hand : hands)
+            {
+                for (size_t i = 0; i < num_cards_per_hand; ++i)
+                {
+                    hand.push_back(deck.back());
+                    deck.pop_back();
+                }
+                std::sort(hand.begin(), hand.end());
+            }
+            os << "seed: " << seed << ", deck: " << to_string(deck) << "\n";
+
+            Piles piles = {1, 1, 100, 100};
+            while (true)
+            {
+                const uint8_t b = read_byte(is);
+                if (b == END_OF_GAME)
+                {
+                    os << "Cards remaining: " << static_cast<int>(read_byte(is)) << "\n";
+                    break;
+                }
+                const size_t hands_index = b >> 4;
+                const HandMask hand_mask = read_byte(is);
+                if (hands_index >= hands.size())
+                {
+                    throw std::runtime_error("Bad turn in trace");
+                }
+                auto &hand = hands[hands_index];
+                os << to_string(piles) << ", hand: " << hands_index << ", "
+                   << to_string(hand) << ", 0x" << std::hex << hand_mask << std::dec
+                   << "\n";
+                for (size_t i = 0; i < piles.size(); ++i)
+                {
+                    if ((b & (1 << i)) != 0)
+                    {
+                        piles[i] = read_byte(is);
+                    }
+                }
+                draw_cards(deck, hand, hand_mask);
+            }
+        }
+    }
+
+} // namespace TheGameAnalyzer
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "deck.hpp"
+#include "turn.hpp"
+
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace TheGameAnalyzer
+{
+    // Compact binary record of played games.
+    //
+    // A trace file starts with the 8 bytes "TGATRC1\n", then each game:
+    //   seed (LEB128), deck (1 byte: 0 std-compat, 1 xoshiro256, 2 the 98
+    //   cards follow as ShuffledDeck::get_cards()), num_players,
+    //   card_reach_distance_normal, card_reach_distance_endgame (1 byte each),
+    //   then each turn (2 - 6 bytes):
+    //     hands_index << 4 | mask of the piles changed, hand_mask, and the
+    //     new card of each changed pile,
+    //   then 0xff and the number of cards remaining.
+    //
+    // The hands and deck aren't stored; decode_game_trace() deals them
+    // again from the deck.
+    class GameTraceFile
+    {
+    public:
+        // Throws std::runtime_error if the file can't be opened.
+        explicit GameTraceFile(const std::string &path);
+        // Closes the file if close() wasn't called, ignoring errors.
+        ~GameTraceFile();
+        GameTraceFile(const GameTraceFile &) = delete;
+        GameTraceFile &operator=(const GameTraceFile &) = delete;
+
+        // Append whole games. Thread safe. A failed write is reported by close().
+        void write(const std::vector<uint8_t> &bytes);
+
+        // Close the file, once every writer is flushed.
+        //
+        // Throws std::runtime_error if a write or closing the file failed.
+        void close();
+
+    private:
+        std::string path_;
+        std::mutex mutex_;
+        std::FILE *file_;
+        bool is_write_failed_{false};
+    };
+
+    // Buffers one thread's games and writes them to a GameTraceFile in blocks.
+    class GameTraceWriter
+    {
+    public:
+        explicit GameTraceWriter(GameTraceFile &file) : file_(file) {}
+        ~GameTraceWriter() { flush(); }
+        GameTraceWriter(const GameTraceWriter &) = delete;
+        GameTraceWriter &operator=(const GameTraceWriter &) = delete;
+
+        // \param deck_rng How the deck was shuffled from seed, or nullopt to store the deck itself.
+        // \param deck Deck before the hands are dealt.
+        void begin_game(uint32_t seed, std::optional<DeckRng> deck_rng, const ShuffledDeck &deck,
+                        int num_players, int card_reach_distance_normal, int card_reach_distance_endgame);
+
+        // \param piles Piles before the turn.
+        // \param turn The turn found, whether or not it was played.
+        void add_turn(size_t hands_index, const Piles &piles, const Turn &turn)
+        {
+            uint8_t changed_piles = 0;
+            for (size_t i = 0; i < piles.size(); ++i)
+            {
+                changed_piles |= piles[i] != turn.piles[i] ? 1 << i : 0;
+            }
+            buffer_.push_back(static_cast<uint8_t>(hands_index << 4 | changed_piles));
+            buffer_.push_back(static_cast<uint8_t>(turn.hand_mask));
+            for (size_t i = 0; i < piles.size(); ++i)
+            {
+                if (piles[i] != turn.piles[i])
+                {
+                    buffer_.push_back(static_cast<uint8_t>(turn.piles[i]));
+                }
+            }
+        }
+
+        void end_game(int num_cards_remaining);
+
+        void flush();
+
+    private:
+        static const size_t FLUSH_BYTES = 1 << 16;
+
+        GameTraceFile &file_;
+        std::vector<uint8_t> buffer_;
+    };
+
+    // Print the games in a trace as PrintGame::Yes does, each followed by
+    // "Cards remaining: n".
+    //
+    // Throws std::runtime_error if the trace is bad.
+    void decode_game_trace(std::istream &is, std::ostream &os);
+
+} // namespace TheGameAnalyzer
@@ -0,0 +1,335 @@
+#include "lookahead.hpp"
+
+#include "card_set.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace TheGameAnalyzer
+{
+    namespace
+    {
+        const int STARTING_MIN_CARDS_PER_TURN = 2;
+
+        // Everything a game needs to carry on. Fixed size and trivially
+        // copyable, so a rollout starts with a plain copy.
+        struct GameState
+        {
+            Piles piles = {1, 1, 100, 100};
+            std::array<Hand, MAX_PLAYERS> hands;
+            Deck deck; // Drawn from the back.
+            size_t num_players{0};
+            size_t hands_index{0};
+            int num_cards_in_game{0};
+        };
+
+        // How many standard errors a candidate must beat the greedy turn by.
+        // Picking the best of many noisy estimates otherwise favours the
+        // candidate that got lucky on the samples.
+        const double MIN_STANDARD_ERRORS = 2.0;
+
+        // A candidate's cards left minus the greedy turn's, over the samples.
+        struct CandidateStats
+        {
+            int64_t sum{0};
+            int64_t sum_of_squares{0};
+        };
+
+        // Reach distances of the game.
+        struct Reach
+        {
+            int normal;
+            int endgame;
+        };
+
+        int get_min_cards_for_turn(const GameState &state)
+        {
+            return state.deck.empty() ? 1 : STARTING_MIN_CARDS_PER_TURN;
+        }
+
+        int get_card_reach_distance(const GameState &state, Reach reach)
+        {
+            return state.deck.empty() ? reach.endgame : reach.normal;
+        }
+
+        // Play the current hand's turn and move on to the next hand.
+        //
+        // \return false if the game is over.
+        bool play_turn(GameState &state, const Turn &turn)
+        {
+            const int num_cards_played = get_num_cards_in_hand_mask(turn.hand_mask);
+            state.num_cards_in_game -= num_cards_played;
+            if (num_cards_played < get_min_cards_for_turn(state))
+            {
+                return false;
+            }
+            state.piles = turn.piles;
+            draw_cards(state.deck, state.hands[state.hands_index], turn.hand_mask);
+            state.hands_index = state.hands_index + 1 == state.num_players ? 0 : state.hands_index + 1;
+            return state.num_cards_in_game > 0;
+        }
+
+        // Skip hands that are out of cards. The game must not be over.
+        void skip_empty_hands(GameState &state)
+        {
+            while (state.hands[state.hands_index].empty())
+            {
+                state.hands_index = state.hands_index + 1 == state.num_players ? 0 : state.hands_index + 1;
+            }
+        }
+
+        Turn find_greedy_turn(const GameState &state, Reach reach)
+        {
+            return find_best_turn(state.piles, state.hands[state.hands_index], get_min_cards_for_turn(state),
+                                  get_card_reach_distance(state, reach));
+        }
+
+        // Play the game out with find_best_turn().
+        //
+        // \return number of cards remaining.
+        int rollout(GameState state, Reach reach)
+        {
+            while (state.num_cards_in_game > 0)
+            {
+                skip_empty_hands(state);
+                if (!play_turn(state, find_greedy_turn(state, reach)))
+                {
+                    break;
+                }
+            }
+            return state.num_cards_in_game;
+        }
+
+        // The current hand's candidate turns, the greedy turn first.
+        void get_candidate_turns(const GameState &state, Reach reach, std::vector<Turn> &candidates)
+        {
+            const auto &piles = state.piles;
+            const auto &hand = state.hands[state.hands_index];
+            const int min_cards_for_turn = get_min_cards_for_turn(state);
+            candidates.assign(1, find_greedy_turn(state, reach));
+            auto add_candidate = [&](const Turn &turn)
+            {
+                if (get_num_cards_in_hand_mask(turn.hand_mask) < min_cards_for_turn)
+                {
+                    return;
+                }
+                const auto it = std::find_if(candidates.begin(), candidates.end(), [&](const Turn &t)
+                                             { return t.hand_mask == turn.hand_mask && t.piles == turn.piles; });
+                if (it == candidates.end())
+                {
+                    candidates.push_back(turn);
+                }
+            };
+            for (int card_reach_distance = MIN_CARD_REACH_DISTANCE; card_reach_distance <= MAX_CARD_REACH_DISTANCE;
+                 ++card_reach_distance)
+            {
+                add_candidate(find_best_turn(piles, hand, min_cards_for_turn, card_reach_distance));
+            }
+            for (int num_cards = min_cards_for_turn + 1; num_cards <= static_cast<int>(hand.size()); ++num_cards)
+            {
+                add_candidate(find_best_turn(piles, hand, num_cards, 0));
+            }
+        }
+
+        // Deal the cards the current hand hasn't seen (the other hands and the
+        // deck) at random, keeping the number of cards in each.
+        void deal_sample(const GameState &state, Xoshiro256 &rng, GameState &sample)
+        {
+            // Cards that were played are on the piles' history, so everyone has seen them.
+            CardSet unseen_cards;
+            for (const auto c : state.deck)
+            {
+                unseen_cards.insert(c);
+            }
+            for (size_t i = 0; i < state.num_players; ++i)
+            {
+                if (i != state.hands_index)
+                {
+                    for (const auto c : state.hands[i])
+                    {
+                        unseen_cards.insert(c);
+                    }
+                }
+            }
+
+            Deck unseen;
+            for (; !unseen_cards.empty(); unseen_cards.erase(unseen_cards.lowest()))
+            {
+                unseen.push_back(unseen_cards.lowest());
+            }
+            for (size_t i = unseen.size(); i > 1; --i)
+            {
+                std::swap(unseen[i - 1], unseen[get_bounded(rng, static_cast<uint32_t>(i))]);
+            }
+
+            sample = state;
+            Card *next = unseen.begin();
+            for (size_t i = 0; i < state.num_players; ++i)
+            {
+                if (i != state.hands_index)
+                {
+                    auto &hand = sample.hands[i];
+                    std::copy(next, next + hand.size(), hand.begin());
+                    next += hand.size();
+                    std::sort(hand.begin(), hand.end());
+                }
+            }
+            std::copy(next, unseen.end(), sample.deck.begin());
+        }
+
+        // Current hand's turn by Monte Carlo lookahead, see play_game_lookahead().
+        Turn find_lookahead_turn(const GameState &state, Reach reach, const LookaheadOptions &options,
+                                 Xoshiro256 &rng, std::vector<Turn> &candidates, std::vector<CandidateStats> &stats)
+        {
+            if (options.num_samples == 0)
+            {
+                return find_greedy_turn(state, reach);
+            }
+            get_candidate_turns(state, reach, candidates);
+            if (candidates.size() == 1)
+            {
+                return candidates.front();
+            }
+            stats.assign(candidates.size(), CandidateStats{});
+            GameState sample;
+            for (unsigned s = 0; s < options.num_samples; ++s)
+            {
+                deal_sample(state, rng, sample);
+                int greedy_num_cards_left = 0;
+                for (size_t i = 0; i < candidates.size(); ++i)
+                {
+                    GameState rollout_state = sample;
+                    const int num_cards_left = play_turn(rollout_state, candidates[i])
+                                                   ? rollout(rollout_state, reach)
+                                                   : rollout_state.num_cards_in_game;
+                    if (i == 0)
+                    {
+                        greedy_num_cards_left = num_cards_left;
+                    }
+                    const int64_t diff = num_cards_left - greedy_num_cards_left;
+                    stats[i].sum += diff;
+                    stats[i].sum_of_squares += diff * diff;
+                }
+            }
+
+            // Best candidate that beats greedy by more than the noise: its mean
+            // difference must be below zero by MIN_STANDARD_ERRORS standard errors.
+            const double n = options.num_samples;
+            size_t best_index = 0;
+            for (size_t i = 1; i < candidates.size(); ++i)
+            {
+                const double mean = static_cast<double>(stats[i].sum) / n;
+                const double variance = std::max(0.0, static_cast<double>(stats[i].sum_of_squares) / n - mean * mean);
+                const bool beats_greedy = mean + MIN_STANDARD_ERRORS * std::sqrt(variance / n) < 0.0;
+                if (beats_greedy && stats[i].sum < stats[best_index].sum)
+                {
+                    best_index = i;
+                }
+            }
+            return candidates[best_index];
+        }
+    } // namespace
+
+    int play_game_lookahead(const ShuffledDeck &shuffled_deck, int num_players, int card_reach_distance_normal,
+                            int card_reach_distance_endgame, const LookaheadOptions &options,
+                            uint64_t sample_seed)
+    {
+        assert(num_players >= MIN_PLAYERS && "Not enough players");
+        assert(num_players <= MAX_PLAYERS && "Too many players");
+        const Reach reach{card_reach_distance_normal, card_reach_distance_endgame};
+
+        // Deal as play_game(), and keep the rest of the deck in the order it's drawn.
+        ShuffledDeck deck = shuffled_deck;
+        GameState state;
+        state.num_players = static_cast<size_t>(num_players);
+        state.num_cards_in_game = static_cast<int>(deck.size());
+        for (size_t i = 0; i < state.num_players; ++i)
+        {
+            auto &hand = state.hands[i];
+            hand.resize(calc_num_cards_per_hand(state.num_players));
+            for (auto &card : hand)
+            {
+                card = deck.draw();
+            }
+            std::sort(hand.begin(), hand.end());
+        }
+        while (!deck.empty())
+        {
+            state.deck.push_back(deck.draw());
+        }
+        std::reverse(state.deck.begin(), state.deck.end());
+
+        // The strongest starting hand, as play_game().
+        std::array<Turn, MAX_PLAYERS> starting_turns;
+        for (size_t i = 0; i < state.num_players; ++i)
+        {
+            starting_turns[i] = find_best_turn(state.piles, state.hands[i], STARTING_MIN_CARDS_PER_TURN,
+                                               card_reach_distance_normal);
+        }
+        const auto starting_turn_it = std::max_element(starting_turns.begin(), starting_turns.begin() + num_players,
+                                                       TurnCompare{STARTING_MIN_CARDS_PER_TURN});
+        state.hands_index = static_cast<size_t>(starting_turn_it - starting_turns.begin());
+
+        Xoshiro256 rng(sample_seed);
+        std::vector<Turn> candidates;
+        std::vector<CandidateStats> stats;
+        while (state.num_cards_in_game > 0)
+        {
+            skip_empty_hands(state);
+            const auto turn = find_lookahead_turn(state, reach, options, rng, candidates, stats);
+            if (!play_turn(state, turn))
+            {
+                break;
+            }
+        }
+        return state.num_cards_in_game;
+    }
+
+    TheGamesResults play_games_lookahead(int num_players, int card_reach_distance_normal,
+                                         int card_reach_distance_endgame, uint64_t num_trials,
+                                         bool do_parallel, const LookaheadOptions &options, DeckRng deck_rng,
+                                         const DeckCorpus *deck_corpus, SchedulerOptions scheduler_options)
+    {
+        assert(num_trials >= MIN_TRIALS);
+        assert(num_trials <= MAX_TRIALS);
+        assert(deck_corpus == nullptr || num_trials <= deck_corpus->size());
+        // A lookahead game is slow, so one game per chunk keeps the threads
+        // balanced, up to MAX_NUM_CHUNKS chunks of consecutive seeds.
+        const uint64_t MAX_NUM_CHUNKS = 4096;
+        const uint64_t num_chunks = std::min(MAX_NUM_CHUNKS, num_trials);
+        if (!do_parallel)
+        {
+            scheduler_options = SchedulerOptions{1, false};
+        }
+        struct alignas(64) ThreadStats
+        {
+            GamesStats games_stats;
+        };
+        std::vector<ThreadStats> threads_stats(get_num_threads(scheduler_options));
+        auto play_chunk = [&](uint64_t chunk_index, unsigned thread_index)
+        {
+            const uint64_t first_seed = num_trials * chunk_index / num_chunks;
+            const uint64_t last_seed = num_trials * (chunk_index + 1) / num_chunks;
+            for (uint64_t seed = first_seed; seed < last_seed; ++seed)
+            {
+                const ShuffledDeck deck = deck_corpus != nullptr ? deck_corpus->get_deck(seed)
+                                                                 : ShuffledDeck(static_cast<uint32_t>(seed), deck_rng);
+                threads_stats[thread_index].games_stats.add(play_game_lookahead(
+                    deck, num_players, card_reach_distance_normal, card_reach_distance_endgame, options, seed));
+            }
+        };
+        parallel_for_chunks(num_chunks, scheduler_options, play_chunk);
+        GamesStats games_stats;
+        for (const auto &thread_stats : threads_stats)
+        {
+            games_stats.merge(thread_stats.games_stats);
+        }
+        return calculate_games_stats(games_stats);
+    }
+
+} // namespace TheGameAnalyzer
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "game.hpp"
+
+#include <cstdint>
+
+namespace TheGameAnalyzer
+{
+    struct LookaheadOptions
+    {
+        // Deals of the unseen cards each candidate turn is rolled out on. 0
+        // always plays the greedy turn, the same as play_game().
+        unsigned num_samples{64};
+    };
+
+    // Play a game where each turn is chosen by Monte Carlo lookahead.
+    //
+    // The candidate turns are the distinct greedy turns for every reach
+    // distance and every number of cards to play. For each sample the player
+    // deals the cards it hasn't seen (the other hands and the deck) at
+    // random, and rolls the game out from each candidate with find_best_turn()
+    // and the given reach distances. All candidates are rolled out on the
+    // same samples. The candidate with the fewest cards left in total is
+    // played if it beats the greedy turn by more than two standard errors,
+    // else the greedy turn is. The starting hand is chosen as play_game().
+    //
+    // \param deck Shuffled deck, before the hands are dealt.
+    // \param num_players Number of players in the game (1-5).
+    // \param card_reach_distance_normal How much to reach for playing another card (before the endgame).
+    // \param card_reach_distance_endgame How much to reach for playing another card during the endgame.
+    // \param options How much to look ahead.
+    // \param sample_seed Seed for dealing the samples.
+    // \return number of cards remaining.
+    int play_game_lookahead(const ShuffledDeck &deck, int num_players, int card_reach_distance_normal,
+                            int card_reach_distance_endgame, const LookaheadOptions &options,
+                            uint64_t sample_seed);
+
+    // Play several trials of play_game_lookahead().
+    //
+    // Trial i plays seed i (or deck i of deck_corpus) with sample seed i. The
+    // trials run in parallel, each one on a single thread.
+    //
+    // \param num_trials Number of trials to run (1-2^32), seeds [0, num_trials).
+    // See play_games() for the other parameters.
+    TheGamesResults play_games_lookahead(int num_players, int card_reach_distance_normal,
+                                         int card_reach_distance_endgame, uint64_t num_trials,
+                                         bool do_parallel, const LookaheadOptions &options,
+                                         DeckRng deck_rng = DeckRng::StdCompat,
+                                         const DeckCorpus *deck_corpus = nullptr,
+                                         SchedulerOptions scheduler_options = {});
+
+} // namespace TheGameAnalyzer
@@ -1,8 +1,73 @@
+#include "endgame.hpp"
 #include "game.hpp"
+#include "lookahead.hpp"
+#include "optimizer.hpp"
+#include "perfect_solver.hpp"
+#include "sweep.hpp"
 
 #include "cxxopts.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Parse an inclusive range like "0-6" (or a single value like "3").
+static std::optional<TheGameAnalyzer::SweepRange> parse_range(const std::string &s)
+{
+    try
+    {
+        const auto dash = s.find('-');
+        TheGameAnalyzer::SweepRange range;
+        range.first = std::stoi(s.substr(0, dash));
+        range.last = dash == std::string::npos ? range.first : std::stoi(s.substr(dash + 1));
+        if (range.first > range.last)
+        {
+            return std::nullopt;
+        }
+        return range;
+    }
+    catch (const std::exception &)
+    {
+        return std::nullopt;
+    }
+}
+
+// Whether all of range is within [min, max].
+static bool is_range_within(const TheGameAnalyzer::SweepRange &range, int min, int max)
+{
+    return range.first >= min && range.last <= max;
+}
+
+// Parse a comma separated list of strategy names, or "all".
+static std::optional<std::vector<TheGameAnalyzer::Strategy>> parse_strategies(const std::string &s)
+{
+    std::vector<TheGameAnalyzer::Strategy> strategies;
+    if (s == "all")
+    {
+        for (size_t i = 0; i < TheGameAnalyzer::NUM_STRATEGIES; ++i)
+        {
+            strategies.push_back(static_cast<TheGameAnalyzer::Strategy>(i));
+        }
+        return strategies;
+    }
+    for (size_t first = 0; first <= s.size();)
+    {
+        const auto comma = std::min(s.find(',', first), s.size());
+        const auto strategy = TheGameAnalyzer::parse_strategy(s.substr(first, comma - first));
+        if (!strategy)
+        {
+            return std::nullopt;
+        }
+        strategies.push_back(*strategy);
+        first = comma + 1;
+    }
+    return strategies;
+}
 
 int main(int argc, char *argv[])
 {
@@ -12,8 +77,39 @@ int main(int argc, char *argv[])
         ("r,card-reach-distance", "How far to reach to play anther card (non-endgame)", cxxopts::value<int>()->default_value("1"))     //
         ("e,card-reach-distance-endgame", "How far to reach to play anther card (endgame)", cxxopts::value<int>()->default_value("1")) //
         ("s,seed", "Run the game once with random seed (0-10,000)", cxxopts::value<uint32_t>()->default_value("0"))                    //
-        ("t,num-trials", "How many trials to play (1-10,000). If 1, print the game", cxxopts::value<int>()->default_value("1"))        //
+        ("t,num-trials", "How many trials to play (1-2^32). If 1, print the game", cxxopts::value<uint64_t>()->default_value("1"))    //
         ("p,parallel", "Run trials in parallel")                                                                                       //
+        ("threads", "Run trials in parallel on this many threads (0 is one per hardware thread)", cxxopts::value<unsigned>())          //
+        ("pin-threads", "Pin each thread to a core")                                                                                   //
+        ("scaling-report", "Time the trials on 1 to --threads threads")                                                                //
+        ("x,turn-engine", "How to choose each turn: greedy or exhaustive", cxxopts::value<std::string>()->default_value("greedy"))      //
+        ("c,turn-cache-mb", "Share a turn cache of this many MB across trials (0 is off)", cxxopts::value<size_t>()->default_value("0")) //
+        ("strategy", "Heuristic to play: basic, one of its ablations or card-memory (see README)", cxxopts::value<std::string>()->default_value("basic")) //
+        ("strategies", "Play these comma separated strategies (or all) over the same decks", cxxopts::value<std::string>())           //
+        ("lookahead-samples", "Choose each turn by rolling out the candidates on this many deals of the unseen cards", cxxopts::value<unsigned>()) //
+        ("endgame-report", "Play 1 player games with the heuristic and a perfect endgame and compare them")               //
+        ("endgame-tablebase", "Endgame report: look positions up in this file (from --write-endgame-tablebase)", cxxopts::value<std::string>()) //
+        ("write-endgame-tablebase", "Solve the endgames of num-trials 1 player games, write them to this file and exit", cxxopts::value<std::string>()) //
+        ("solve-perfect", "Search each seed for the fewest cards left with every card known, next to the heuristic (1-2 players)") //
+        ("solver-nodes", "Solve perfect: search nodes per seed", cxxopts::value<uint64_t>()->default_value("1000000"))      //
+        ("optimize", "Search reach distances by stage of the game and the 10-group rule for num-players, starting from -r and -e") //
+        ("optimize-population", "Optimize: candidates per generation", cxxopts::value<unsigned>()->default_value("32"))      //
+        ("optimize-elites", "Optimize: best candidates the next generation is sampled around", cxxopts::value<unsigned>()->default_value("8")) //
+        ("optimize-generations", "Optimize: number of generations", cxxopts::value<unsigned>()->default_value("20"))     //
+        ("optimize-checkpoint", "Optimize: resume from this file if it exists, and write it after each generation", cxxopts::value<std::string>()) //
+        ("g,deck-rng", "How to shuffle the deck: std-compat or xoshiro256", cxxopts::value<std::string>()->default_value("std-compat")) //
+        ("deck-corpus", "Play the decks in this file (from --write-deck-corpus) instead of shuffling", cxxopts::value<std::string>()) //
+        ("write-deck-corpus", "Write num-trials shuffled decks to this file and exit", cxxopts::value<std::string>())                 //
+        ("trace", "Record every game played to this file", cxxopts::value<std::string>())                                             //
+        ("decode-trace", "Print the games in this file (from --trace) and exit", cxxopts::value<std::string>())                       //
+        ("metrics-file", "Write hot path metrics to this file (needs a TGA_METRICS build)", cxxopts::value<std::string>())          //
+        ("w,sweep", "Play every configuration in a grid over the same decks")                                                          //
+        ("race", "Find the best reach distances for num-players, dropping configurations once they're clearly worse") //
+        ("race-confidence", "Race: confidence level of the whole race, each comparison is Bonferroni corrected", cxxopts::value<double>()->default_value("0.95")) //
+        ("sweep-players", "Sweep: range of number of players", cxxopts::value<std::string>()->default_value("1-5"))                    //
+        ("sweep-reach", "Sweep: range of reach distances (non-endgame)", cxxopts::value<std::string>()->default_value("0-6"))          //
+        ("sweep-reach-endgame", "Sweep: range of reach distances (endgame)", cxxopts::value<std::string>()->default_value("0-13"))     //
+        ("sweep-format", "Sweep: json or markdown", cxxopts::value<std::string>()->default_value("markdown"))                          //
         ("h,help", "Print usage");
 
     const auto result = options.parse(argc, argv);
@@ -28,15 +124,443 @@ int main(int argc, char *argv[])
     const int num_players = result["num-players"].as<int>();
     const int card_reach_distance_normal = result["card-reach-distance"].as<int>();
     const int card_reach_distance_endgame = result["card-reach-distance-endgame"].as<int>();
-    const int num_trials = result["num-trials"].as<int>();
-    const bool do_parallel = result["parallel"].as<bool>();
+    uint64_t num_trials = result["num-trials"].as<uint64_t>();
+    const bool do_parallel = result["parallel"].as<bool>() || result.count("threads");
+    TheGameAnalyzer::SchedulerOptions scheduler_options;
+    scheduler_options.num_threads = result.count("threads") ? result["threads"].as<unsigned>() : 0;
+    scheduler_options.pin_threads = result["pin-threads"].as<bool>();
+    const size_t turn_cache_bytes = result["turn-cache-mb"].as<size_t>() << 20;
+    const auto turn_engine_name = result["turn-engine"].as<std::string>();
+    TheGameAnalyzer::TurnEngine turn_engine = TheGameAnalyzer::TurnEngine::Greedy;
+    if (turn_engine_name == "exhaustive")
+    {
+        turn_engine = TheGameAnalyzer::TurnEngine::Exhaustive;
+    }
+    else if (turn_engine_name != "greedy")
+    {
+        std::cerr << "Unknown turn engine: " << turn_engine_name << "\n";
+        return 1;
+    }
+
+    const auto strategy_name = result["strategy"].as<std::string>();
+    const auto strategy = TheGameAnalyzer::parse_strategy(strategy_name);
+    if (!strategy)
+    {
+        std::cerr << "Unknown strategy: " << strategy_name << "\n";
+        return 1;
+    }
+    if (*strategy != TheGameAnalyzer::Strategy::Basic && turn_engine != TheGameAnalyzer::TurnEngine::Greedy)
+    {
+        std::cerr << "Strategies other than basic need the greedy turn engine\n";
+        return 1;
+    }
+    if (result.count("strategy"))
+    {
+        // These modes play their own strategies (or the basic one).
+        for (const char *option : {"write-deck-corpus", "write-endgame-tablebase", "decode-trace", "race", "sweep",
+                                   "strategies", "endgame-report", "optimize", "solve-perfect"})
+        {
+            if (result.count(option))
+            {
+                std::cerr << "--strategy can't be used with --" << option << "\n";
+                return 1;
+            }
+        }
+    }
+
+    const auto deck_rng_name = result["deck-rng"].as<std::string>();
+    TheGameAnalyzer::DeckRng deck_rng = TheGameAnalyzer::DeckRng::StdCompat;
+    if (deck_rng_name == "xoshiro256")
+    {
+        deck_rng = TheGameAnalyzer::DeckRng::Xoshiro256;
+    }
+    else if (deck_rng_name != "std-compat")
+    {
+        std::cerr << "Unknown deck rng: " << deck_rng_name << "\n";
+        return 1;
+    }
+
+    if (result.count("metrics-file"))
+    {
+        if (!TheGameAnalyzer::METRICS_ENABLED)
+        {
+            std::cerr << "--metrics-file needs a build with TGA_METRICS (make thegameanalyzer_metrics)\n";
+            return 1;
+        }
+        // Only the plain trials (play_games()) collect metrics.
+        for (const char *option : {"write-deck-corpus", "write-endgame-tablebase", "decode-trace", "race", "sweep",
+                                   "strategies", "endgame-report", "optimize", "solve-perfect", "lookahead-samples",
+                                   "scaling-report"})
+        {
+            if (result.count(option))
+            {
+                std::cerr << "--metrics-file can't be used with --" << option << "\n";
+                return 1;
+            }
+        }
+    }
+
+    if (result.count("trace"))
+    {
+        // Only the plain trials (play_games()) record games.
+        for (const char *option : {"write-deck-corpus", "write-endgame-tablebase", "decode-trace", "race", "sweep",
+                                   "strategies", "endgame-report", "optimize", "solve-perfect", "lookahead-samples",
+                                   "scaling-report"})
+        {
+            if (result.count(option))
+            {
+                std::cerr << "--trace can't be used with --" << option << "\n";
+                return 1;
+            }
+        }
+    }
+
+    if (result.count("turn-cache-mb"))
+    {
+        // Only the plain trials (play_games()) share a turn cache.
+        for (const char *option : {"write-deck-corpus", "write-endgame-tablebase", "decode-trace", "race", "sweep",
+                                   "strategies", "endgame-report", "optimize", "solve-perfect", "lookahead-samples"})
+        {
+            if (result.count(option))
+            {
+                std::cerr << "--turn-cache-mb can't be used with --" << option << "\n";
+                return 1;
+            }
+        }
+    }
+
+    if (result.count("write-deck-corpus"))
+    {
+        const auto path = result["write-deck-corpus"].as<std::string>();
+        try
+        {
+            TheGameAnalyzer::write_deck_corpus(path, num_trials, deck_rng);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (result.count("write-endgame-tablebase"))
+    {
+        const auto path = result["write-endgame-tablebase"].as<std::string>();
+        try
+        {
+            TheGameAnalyzer::write_endgame_tablebase(path, card_reach_distance_normal, num_trials, deck_rng);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (result.count("decode-trace"))
+    {
+        const auto path = result["decode-trace"].as<std::string>();
+        std::ifstream is(path, std::ios::binary);
+        if (!is)
+        {
+            std::cerr << "Can't open trace: " << path << "\n";
+            return 1;
+        }
+        try
+        {
+            TheGameAnalyzer::decode_game_trace(is, std::cout);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    std::unique_ptr<TheGameAnalyzer::DeckCorpus> deck_corpus;
+    if (result.count("deck-corpus"))
+    {
+        try
+        {
+            deck_corpus = std::make_unique<TheGameAnalyzer::DeckCorpus>(result["deck-corpus"].as<std::string>());
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        if (result.count("seed"))
+        {
+            std::cerr << "--seed can't be used with --deck-corpus\n";
+            return 1;
+        }
+        // Default to every deck in the corpus.
+        if (!result.count("num-trials"))
+        {
+            num_trials = deck_corpus->size();
+        }
+        else if (num_trials > deck_corpus->size())
+        {
+            std::cerr << "Only " << deck_corpus->size() << " decks in the corpus\n";
+            return 1;
+        }
+    }
+
+    if (result.count("race"))
+    {
+        const auto sweep_reach = parse_range(result["sweep-reach"].as<std::string>());
+        const auto sweep_reach_endgame = parse_range(result["sweep-reach-endgame"].as<std::string>());
+        const double race_confidence = result["race-confidence"].as<double>();
+        if (!sweep_reach || !sweep_reach_endgame)
+        {
+            std::cerr << "Bad sweep range, expected e.g. 0-6\n";
+            return 1;
+        }
+        if (!is_range_within(*sweep_reach, TheGameAnalyzer::MIN_CARD_REACH_DISTANCE,
+                             TheGameAnalyzer::MAX_CARD_REACH_DISTANCE) ||
+            !is_range_within(*sweep_reach_endgame, TheGameAnalyzer::MIN_CARD_REACH_DISTANCE,
+                             TheGameAnalyzer::MAX_CARD_REACH_DISTANCE))
+        {
+            std::cerr << "Sweep reach distances must be within " << TheGameAnalyzer::MIN_CARD_REACH_DISTANCE << "-"
+                      << TheGameAnalyzer::MAX_CARD_REACH_DISTANCE << "\n";
+            return 1;
+        }
+        if (num_players < TheGameAnalyzer::MIN_PLAYERS || num_players > TheGameAnalyzer::MAX_PLAYERS)
+        {
+            std::cerr << "--race needs " << TheGameAnalyzer::MIN_PLAYERS << "-" << TheGameAnalyzer::MAX_PLAYERS
+                      << " players\n";
+            return 1;
+        }
+        if (sweep_reach_endgame->last < sweep_reach->first)
+        {
+            std::cerr << "No configurations to race, the endgame reach distance must be at least the normal one\n";
+            return 1;
+        }
+        if (!(race_confidence > 0.0 && race_confidence < 1.0))
+        {
+            std::cerr << "Race confidence must be between 0 and 1\n";
+            return 1;
+        }
+        const auto race_result = TheGameAnalyzer::play_race(num_players, *sweep_reach, *sweep_reach_endgame, num_trials,
+                                                            race_confidence, do_parallel, turn_engine, deck_rng,
+                                                            deck_corpus.get(), scheduler_options);
+        std::cout << to_string(race_result);
+        return 0;
+    }
+
+    if (result.count("sweep"))
+    {
+        const auto sweep_players = parse_range(result["sweep-players"].as<std::string>());
+        const auto sweep_reach = parse_range(result["sweep-reach"].as<std::string>());
+        const auto sweep_reach_endgame = parse_range(result["sweep-reach-endgame"].as<std::string>());
+        const auto sweep_format = result["sweep-format"].as<std::string>();
+        if (!sweep_players || !sweep_reach || !sweep_reach_endgame)
+        {
+            std::cerr << "Bad sweep range, expected e.g. 0-6\n";
+            return 1;
+        }
+        if (!is_range_within(*sweep_players, TheGameAnalyzer::MIN_PLAYERS, TheGameAnalyzer::MAX_PLAYERS))
+        {
+            std::cerr << "Sweep players must be within " << TheGameAnalyzer::MIN_PLAYERS << "-"
+                      << TheGameAnalyzer::MAX_PLAYERS << "\n";
+            return 1;
+        }
+        if (!is_range_within(*sweep_reach, TheGameAnalyzer::MIN_CARD_REACH_DISTANCE,
+                             TheGameAnalyzer::MAX_CARD_REACH_DISTANCE) ||
+            !is_range_within(*sweep_reach_endgame, TheGameAnalyzer::MIN_CARD_REACH_DISTANCE,
+                             TheGameAnalyzer::MAX_CARD_REACH_DISTANCE))
+        {
+            std::cerr << "Sweep reach distances must be within " << TheGameAnalyzer::MIN_CARD_REACH_DISTANCE << "-"
+                      << TheGameAnalyzer::MAX_CARD_REACH_DISTANCE << "\n";
+            return 1;
+        }
+        if (sweep_format != "json" && sweep_format != "markdown")
+        {
+            std::cerr << "Unknown sweep format: " << sweep_format << "\n";
+            return 1;
+        }
+        const auto cells = TheGameAnalyzer::play_sweep(*sweep_players, *sweep_reach, *sweep_reach_endgame,
+                                                       num_trials, do_parallel, turn_engine, deck_rng,
+                                                       deck_corpus.get(), scheduler_options);
+        std::cout << (sweep_format == "json" ? TheGameAnalyzer::to_json(cells) : TheGameAnalyzer::to_markdown(cells));
+        return 0;
+    }
+
+    if (result.count("strategies"))
+    {
+        const auto strategies = parse_strategies(result["strategies"].as<std::string>());
+        if (!strategies)
+        {
+            std::cerr << "Bad strategies, expected e.g. basic,first-hand-starts\n";
+            return 1;
+        }
+        const auto cells = TheGameAnalyzer::play_strategies(num_players, card_reach_distance_normal,
+                                                            card_reach_distance_endgame, *strategies, num_trials,
+                                                            do_parallel, deck_rng, deck_corpus.get(), scheduler_options);
+        std::cout << TheGameAnalyzer::to_json(cells);
+        return 0;
+    }
+
+    if (result.count("endgame-report"))
+    {
+        if (num_players != 1)
+        {
+            std::cerr << "--endgame-report needs 1 player (the other hands are hidden in the endgame)\n";
+            return 1;
+        }
+        std::unique_ptr<TheGameAnalyzer::EndgameTablebase> endgame_tablebase;
+        if (result.count("endgame-tablebase"))
+        {
+            try
+            {
+                endgame_tablebase = std::make_unique<TheGameAnalyzer::EndgameTablebase>(
+                    result["endgame-tablebase"].as<std::string>());
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << e.what() << "\n";
+                return 1;
+            }
+        }
+        const auto report = TheGameAnalyzer::play_games_endgame(
+            card_reach_distance_normal, card_reach_distance_endgame, num_trials, do_parallel, endgame_tablebase.get(),
+            deck_rng, deck_corpus.get(), scheduler_options);
+        std::cout << to_string(report) << "\n";
+        return 0;
+    }
+
+    if (result.count("optimize"))
+    {
+        if (deck_corpus)
+        {
+            std::cerr << "--optimize shuffles its decks, validating on the seeds after num-trials\n";
+            return 1;
+        }
+        TheGameAnalyzer::OptimizerOptions optimizer_options;
+        optimizer_options.population_size = result["optimize-population"].as<unsigned>();
+        optimizer_options.num_elites = result["optimize-elites"].as<unsigned>();
+        optimizer_options.num_generations = result["optimize-generations"].as<unsigned>();
+        optimizer_options.sample_seed = seed;
+        if (result.count("optimize-checkpoint"))
+        {
+            optimizer_options.checkpoint_path = result["optimize-checkpoint"].as<std::string>();
+        }
+        if (optimizer_options.population_size == 0 || optimizer_options.num_elites == 0 ||
+            optimizer_options.num_elites > optimizer_options.population_size)
+        {
+            std::cerr << "Bad --optimize-population or --optimize-elites, need 1 <= elites <= population\n";
+            return 1;
+        }
+        try
+        {
+            const auto optimizer_result = TheGameAnalyzer::optimize_strategy(
+                num_players, card_reach_distance_normal, card_reach_distance_endgame, num_trials, do_parallel,
+                optimizer_options, deck_rng, scheduler_options,
+                [](const TheGameAnalyzer::OptimizerState &state)
+                { std::cout << TheGameAnalyzer::to_json(state) << std::flush; });
+            std::cout << to_string(optimizer_result);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (result.count("solve-perfect"))
+    {
+        if (num_players > 2)
+        {
+            std::cerr << "--solve-perfect plays 1 or 2 players\n";
+            return 1;
+        }
+        const TheGameAnalyzer::PerfectSolverOptions perfect_solver_options{result["solver-nodes"].as<uint64_t>()};
+        const auto perfect_solve_results = TheGameAnalyzer::solve_perfect_seeds(
+            num_players, card_reach_distance_normal, card_reach_distance_endgame, num_trials, do_parallel,
+            perfect_solver_options, deck_rng, deck_corpus.get(), scheduler_options);
+        std::cout << TheGameAnalyzer::to_json(perfect_solve_results);
+        return 0;
+    }
+
+    if (result.count("lookahead-samples"))
+    {
+        if (*strategy != TheGameAnalyzer::Strategy::Basic || turn_engine != TheGameAnalyzer::TurnEngine::Greedy)
+        {
+            std::cerr << "--lookahead-samples plays the basic strategy with the greedy turn engine\n";
+            return 1;
+        }
+        const TheGameAnalyzer::LookaheadOptions lookahead_options{result["lookahead-samples"].as<unsigned>()};
+        const auto the_games_results = TheGameAnalyzer::play_games_lookahead(
+            num_players, card_reach_distance_normal, card_reach_distance_endgame, num_trials, do_parallel,
+            lookahead_options, deck_rng, deck_corpus.get(), scheduler_options);
+        std::cout << to_string(the_games_results) << "\n";
+        return 0;
+    }
+
+    if (result.count("scaling-report"))
+    {
+        const unsigned max_threads = TheGameAnalyzer::get_num_threads(scheduler_options);
+        double seconds_1_thread = 0.0;
+        for (unsigned num_threads = 1; num_threads <= max_threads; ++num_threads)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            TheGameAnalyzer::play_games(num_players, card_reach_distance_normal, card_reach_distance_endgame,
+                                        num_trials, true, turn_engine, turn_cache_bytes, deck_rng,
+                                        deck_corpus.get(), {num_threads, scheduler_options.pin_threads}, nullptr,
+                                        *strategy);
+            const auto stop = std::chrono::steady_clock::now();
+            const double seconds = std::chrono::duration<double>(stop - start).count();
+            if (num_threads == 1)
+            {
+                seconds_1_thread = seconds;
+            }
+            std::cout << "{ \"num_threads\": " << num_threads
+                      << ", \"seconds\": " << seconds
+                      << ", \"games_per_second\": " << static_cast<double>(num_trials) / seconds
+                      << ", \"speedup\": " << seconds_1_thread / seconds
+                      << "}" << std::endl;
+        }
+        return 0;
+    }
+
+    std::unique_ptr<TheGameAnalyzer::GameTraceFile> game_trace;
+    if (result.count("trace"))
+    {
+        try
+        {
+            game_trace = std::make_unique<TheGameAnalyzer::GameTraceFile>(result["trace"].as<std::string>());
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        if (result.count("seed"))
+        {
+            std::cerr << "--seed can't be used with --trace\n";
+            return 1;
+        }
+    }
 
-    if (result.count("seed") || num_trials == 1)
+    if (!deck_corpus && !game_trace && (result.count("seed") || num_trials == 1))
     {
+        if (result.count("metrics-file"))
+        {
+            std::cerr << "--metrics-file needs more than one trial, and no --seed\n";
+            return 1;
+        }
         int num_cards_remaining = TheGameAnalyzer::play_game(seed, num_players,
                                                              card_reach_distance_normal,
                                                              card_reach_distance_endgame,
-                                                             TheGameAnalyzer::PrintGame::Yes);
+                                                             TheGameAnalyzer::PrintGame::Yes,
+                                                             turn_engine,
+                                                             nullptr,
+                                                             deck_rng,
+                                                             *strategy);
         std::cout << "Cards remaining: " << num_cards_remaining << "\n";
     }
     else
@@ -45,9 +569,39 @@ int main(int argc, char *argv[])
                                                                    card_reach_distance_normal,
                                                                    card_reach_distance_endgame,
                                                                    num_trials,
-                                                                   do_parallel);
+                                                                   do_parallel,
+                                                                   turn_engine,
+                                                                   turn_cache_bytes,
+                                                                   deck_rng,
+                                                                   deck_corpus.get(),
+                                                                   scheduler_options,
+                                                                   game_trace.get(),
+                                                                   *strategy);
 
         std::cout << to_string(the_games_results) << "\n";
+        if (game_trace)
+        {
+            try
+            {
+                game_trace->close();
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << e.what() << "\n";
+                return 1;
+            }
+        }
+        if (result.count("metrics-file"))
+        {
+            const auto path = result["metrics-file"].as<std::string>();
+            std::ofstream os(path);
+            os << TheGameAnalyzer::to_metrics_text(*the_games_results.metrics);
+            if (!os)
+            {
+                std::cerr << "Can't write metrics: " << path << "\n";
+                return 1;
+            }
+        }
     }
     return 0;
 }
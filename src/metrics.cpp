@@ -0,0 +1,73 @@
+#include "metrics.hpp"
+
+#include <cassert>
+#include <sstream>
+
+namespace TheGameAnalyzer
+{
+    std::string to_string(Metric metric)
+    {
+        switch (metric)
+        {
+        case Metric::PilesOfPlays:
+            return "piles_of_plays";
+        case Metric::BestMinCards:
+            return "best_min_cards";
+        case Metric::ReachCards:
+            return "reach_cards";
+        case Metric::DrawCards:
+            return "draw_cards";
+        case Metric::DeckShuffle:
+            return "deck_shuffle";
+        case Metric::DealHands:
+            return "deal_hands";
+        }
+        assert(false);
+        return "";
+    }
+
+    void MetricsStats::merge(const MetricsStats &other)
+    {
+        for (size_t i = 0; i < NUM_METRICS; ++i)
+        {
+            calls[i] += other.calls[i];
+            cycles[i] += other.cycles[i];
+        }
+    }
+
+    std::string to_json(const MetricsStats &stats)
+    {
+        std::ostringstream oss;
+        oss << "{";
+        for (size_t i = 0; i < NUM_METRICS; ++i)
+        {
+            const auto name = to_string(static_cast<Metric>(i));
+            oss << (i == 0 ? " " : ", ")
+                << "\"" << name << "_calls\": " << stats.calls[i]
+                << ", \"" << name << "_cycles\": " << stats.cycles[i];
+        }
+        oss << "}";
+        return oss.str();
+    }
+
+    std::string to_metrics_text(const MetricsStats &stats)
+    {
+        std::ostringstream oss;
+        oss << "# HELP thegameanalyzer_calls_total Calls to each hot path section.\n"
+            << "# TYPE thegameanalyzer_calls_total counter\n";
+        for (size_t i = 0; i < NUM_METRICS; ++i)
+        {
+            oss << "thegameanalyzer_calls_total{section=\"" << to_string(static_cast<Metric>(i)) << "\"} "
+                << stats.calls[i] << "\n";
+        }
+        oss << "# HELP thegameanalyzer_cycles_total Cycles spent in each hot path section.\n"
+            << "# TYPE thegameanalyzer_cycles_total counter\n";
+        for (size_t i = 0; i < NUM_METRICS; ++i)
+        {
+            oss << "thegameanalyzer_cycles_total{section=\"" << to_string(static_cast<Metric>(i)) << "\"} "
+                << stats.cycles[i] << "\n";
+        }
+        return oss.str();
+    }
+
+} // namespace TheGameAnalyzer
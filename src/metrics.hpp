@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#if defined(TGA_METRICS) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#elif defined(TGA_METRICS)
+#include <chrono>
+#endif
+
+namespace TheGameAnalyzer
+{
+    // Hot path sections with a call counter and cycle timer.
+    enum class Metric
+    {
+        PilesOfPlays,  // get_piles_of_plays()
+        BestMinCards,  // get_best_min_cards_all_piles()
+        ReachCards,    // play_reach_cards()
+        DrawCards,     // Drawing after each turn.
+        DeckShuffle,   // Constructing a ShuffledDeck.
+        DealHands,     // Dealing the starting hands.
+    };
+    const size_t NUM_METRICS = 6;
+
+    std::string to_string(Metric);
+
+    struct MetricsStats
+    {
+        std::array<uint64_t, NUM_METRICS> calls{};
+        std::array<uint64_t, NUM_METRICS> cycles{};
+
+        void merge(const MetricsStats &other);
+    };
+
+    // \return JSON object with the calls and cycles of each metric.
+    std::string to_json(const MetricsStats &);
+
+    // \return The metrics in the Prometheus text format.
+    std::string to_metrics_text(const MetricsStats &);
+
+#ifdef TGA_METRICS
+    const bool METRICS_ENABLED = true;
+
+    // This thread's metrics since the last take_thread_metrics().
+    inline thread_local MetricsStats thread_metrics;
+
+    inline uint64_t read_cycles()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    // Counts a call to a section and the cycles until it goes out of scope.
+    class MetricsTimer
+    {
+    public:
+        explicit MetricsTimer(Metric metric) : metric_(static_cast<size_t>(metric)), start_(read_cycles()) {}
+        ~MetricsTimer()
+        {
+            ++thread_metrics.calls[metric_];
+            thread_metrics.cycles[metric_] += read_cycles() - start_;
+        }
+        MetricsTimer(const MetricsTimer &) = delete;
+        MetricsTimer &operator=(const MetricsTimer &) = delete;
+
+    private:
+        size_t metric_;
+        uint64_t start_;
+    };
+
+#define TGA_METRICS_TIMER(metric) const TheGameAnalyzer::MetricsTimer metrics_timer_(metric)
+
+    // \return This thread's metrics, and reset them.
+    inline MetricsStats take_thread_metrics()
+    {
+        const MetricsStats stats = thread_metrics;
+        thread_metrics = MetricsStats{};
+        return stats;
+    }
+#else
+    const bool METRICS_ENABLED = false;
+
+#define TGA_METRICS_TIMER(metric)
+
+    inline MetricsStats take_thread_metrics()
+    {
+        return {};
+    }
+#endif
+
+} // namespace TheGameAnalyzer
@@ -0,0 +1,426 @@
+#include "optimizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace TheGameAnalyzer
+{
+    namespace
+    {
+        const char CHECKPOINT_MAGIC[] = "TGAOPT2";
+
+        // Seeds per scheduler chunk. A chunk plays one candidate.
+        const uint64_t CHUNK_SIZE = 64;
+
+        // Reach distance spread of the first generation.
+        const double INITIAL_REACH_STDDEV = 3.0;
+
+        // Below this the rounded reach distances hardly vary any more.
+        const double MIN_REACH_STDDEV = 0.25;
+
+        // How far each generation moves the distribution towards its elites.
+        const double SMOOTHING = 0.7;
+
+        // Keep trying both sides of the 10-group rule now and then.
+        const double MIN_PROBABILITY = 0.05;
+
+        const double PI = 3.14159265358979323846;
+
+        // Uniform in [0, 1).
+        double get_uniform(Xoshiro256 &rng)
+        {
+            return static_cast<double>(rng() >> 11) * 0x1.0p-53;
+        }
+
+        // Standard normal (Box-Muller), the same on every platform unlike std::normal_distribution.
+        double get_normal(Xoshiro256 &rng)
+        {
+            const double u1 = 1.0 - get_uniform(rng);
+            const double u2 = get_uniform(rng);
+            return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * PI * u2);
+        }
+
+        StrategyParams sample_params(const OptimizerState &state, Xoshiro256 &rng)
+        {
+            StrategyParams params;
+            for (size_t i = 0; i < NUM_REACH_STAGES; ++i)
+            {
+                const double reach = std::round(state.reach_mean[i] + state.reach_stddev[i] * get_normal(rng));
+                params.reach_schedule.card_reach_distances[i] = static_cast<int>(std::clamp(
+                    reach, static_cast<double>(MIN_CARD_REACH_DISTANCE), static_cast<double>(MAX_CARD_REACH_DISTANCE)));
+            }
+            params.skip_near_group_card = get_uniform(rng) < state.skip_near_group_card_probability;
+            return params;
+        }
+
+        // Play every candidate on seeds [first_seed, first_seed + num_trials).
+        std::vector<TheGamesResults> play_candidates(int num_players, const std::vector<StrategyParams> &candidates,
+                                                     uint64_t first_seed, uint64_t num_trials, bool do_parallel,
+                                                     DeckRng deck_rng, SchedulerOptions scheduler_options)
+        {
+            const uint64_t num_chunks_per_candidate = (num_trials + CHUNK_SIZE - 1) / CHUNK_SIZE;
+            if (!do_parallel)
+            {
+                scheduler_options = SchedulerOptions{1, false};
+            }
+            struct alignas(64) ThreadStats
+            {
+                std::vector<GamesStats> games_stats; // By candidate.
+            };
+            std::vector<ThreadStats> threads_stats(get_num_threads(scheduler_options));
+            for (auto &thread_stats : threads_stats)
+            {
+                thread_stats.games_stats.resize(candidates.size());
+            }
+            auto play_chunk = [&](uint64_t chunk_index, unsigned thread_index)
+            {
+                const size_t candidate_index = static_cast<size_t>(chunk_index / num_chunks_per_candidate);
+                const uint64_t candidate_chunk_index = chunk_index % num_chunks_per_candidate;
+                const uint64_t first = first_seed + num_trials * candidate_chunk_index / num_chunks_per_candidate;
+                const uint64_t last = first_seed + num_trials * (candidate_chunk_index + 1) / num_chunks_per_candidate;
+                const auto &params = candidates[candidate_index];
+                const Strategy strategy = get_strategy(params);
+                auto &games_stats = threads_stats[thread_index].games_stats[candidate_index];
+                for (uint64_t seed = first; seed < last; ++seed)
+                {
+                    const ShuffledDeck deck(static_cast<uint32_t>(seed), deck_rng);
+                    games_stats.add(play_game(deck, num_players, params.reach_schedule, strategy));
+                }
+            };
+            parallel_for_chunks(candidates.size() * num_chunks_per_candidate, scheduler_options, play_chunk);
+
+            std::vector<TheGamesResults> results;
+            for (size_t i = 0; i < candidates.size(); ++i)
+            {
+                GamesStats games_stats;
+                for (const auto &thread_stats : threads_stats)
+                {
+                    games_stats.merge(thread_stats.games_stats[i]);
+                }
+                results.push_back(calculate_games_stats(games_stats));
+            }
+            return results;
+        }
+
+        // Move the distribution towards the elites.
+        void update_distribution(OptimizerState &state, const std::vector<const OptimizerCandidate *> &elites)
+        {
+            const double n = static_cast<double>(elites.size());
+            for (size_t i = 0; i < NUM_REACH_STAGES; ++i)
+            {
+                double sum = 0.0;
+                double sum_of_squares = 0.0;
+                for (const auto *elite : elites)
+                {
+                    const double reach = elite->params.reach_schedule.card_reach_distances[i];
+                    sum += reach;
+                    sum_of_squares += reach * reach;
+                }
+                const double mean = sum / n;
+                const double stddev = std::sqrt(std::max(0.0, sum_of_squares / n - mean * mean));
+                state.reach_mean[i] = SMOOTHING * mean + (1.0 - SMOOTHING) * state.reach_mean[i];
+                state.reach_stddev[i] = std::max(MIN_REACH_STDDEV,
+                                                 SMOOTHING * stddev + (1.0 - SMOOTHING) * state.reach_stddev[i]);
+            }
+            const double num_skip = static_cast<double>(std::count_if(
+                elites.begin(), elites.end(), [](const OptimizerCandidate *elite)
+                { return elite->params.skip_near_group_card; }));
+            state.skip_near_group_card_probability = std::clamp(
+                SMOOTHING * num_skip / n + (1.0 - SMOOTHING) * state.skip_near_group_card_probability,
+                MIN_PROBABILITY, 1.0 - MIN_PROBABILITY);
+        }
+
+        void write_params(std::ostream &os, const StrategyParams &params)
+        {
+            for (const int reach : params.reach_schedule.card_reach_distances)
+            {
+                os << reach << ' ';
+            }
+            os << params.skip_near_group_card;
+        }
+
+        bool read_params(std::istream &is, StrategyParams &params)
+        {
+            for (auto &reach : params.reach_schedule.card_reach_distances)
+            {
+                if (!(is >> reach) || reach < MIN_CARD_REACH_DISTANCE || reach > MAX_CARD_REACH_DISTANCE)
+                {
+                    return false;
+                }
+            }
+            return static_cast<bool>(is >> params.skip_near_group_card);
+        }
+
+        // Read "name" and then the values.
+        template <typename... Values>
+        void read_field(std::istream &is, const std::string &path, const char *name, Values &...values)
+        {
+            std::string field;
+            if (!(is >> field) || field != name || !(is >> ... >> values))
+            {
+                throw std::runtime_error("Bad optimizer checkpoint (" + std::string(name) + "): " + path);
+            }
+        }
+
+        // Read "name" and a value that has to be the search's.
+        template <typename Value>
+        void read_search_field(std::istream &is, const std::string &path, const char *name, const Value &search_value)
+        {
+            Value value{};
+            read_field(is, path, name, value);
+            if (value != search_value)
+            {
+                throw std::runtime_error("Optimizer checkpoint is for another search (" + std::string(name) + "): " + path);
+            }
+        }
+    } // namespace
+
+    bool operator==(const StrategyParams &p1, const StrategyParams &p2)
+    {
+        return p1.reach_schedule.card_reach_distances == p2.reach_schedule.card_reach_distances &&
+               p1.skip_near_group_card == p2.skip_near_group_card;
+    }
+
+    Strategy get_strategy(const StrategyParams &params)
+    {
+        return params.skip_near_group_card ? Strategy::Basic : Strategy::ReachNearGroupCard;
+    }
+
+    std::string to_string(const StrategyParams &params)
+    {
+        std::ostringstream oss;
+        oss << "{\"card_reach_distances\": [";
+        const auto &reaches = params.reach_schedule.card_reach_distances;
+        for (size_t i = 0; i < reaches.size(); ++i)
+        {
+            oss << (i == 0 ? "" : ", ") << reaches[i];
+        }
+        oss << "], \"strategy\": \"" << to_string(get_strategy(params)) << "\"}";
+        return oss.str();
+    }
+
+    std::string to_json(const OptimizerState &state)
+    {
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(3);
+        oss << "{ \"generation\": " << state.generation << ", \"reach_mean\": [";
+        for (size_t i = 0; i < NUM_REACH_STAGES; ++i)
+        {
+            oss << (i == 0 ? "" : ", ") << state.reach_mean[i];
+        }
+        oss << "], \"reach_stddev\": [";
+        for (size_t i = 0; i < NUM_REACH_STAGES; ++i)
+        {
+            oss << (i == 0 ? "" : ", ") << state.reach_stddev[i];
+        }
+        oss << "], \"skip_near_group_card_probability\": " << state.skip_near_group_card_probability
+            << ", \"best\": " << to_string(state.best.params)
+            << ", \"best_cards_left_average\": " << state.best.cards_left_average << "}\n";
+        return oss.str();
+    }
+
+    void write_optimizer_checkpoint(const std::string &path, const OptimizerSearch &search,
+                                    const OptimizerState &state)
+    {
+        // Write a new file and rename it over the old one, so a run killed
+        // part way through a write still leaves the last checkpoint.
+        const std::string tmp_path = path + ".tmp";
+        {
+            std::ofstream ofs(tmp_path);
+            ofs << std::setprecision(17);
+            ofs << CHECKPOINT_MAGIC << "\n"
+                << "num_players " << search.num_players << "\n"
+                << "num_trials " << search.num_trials << "\n"
+                << "card_reach_distance_normal " << search.card_reach_distance_normal << "\n"
+                << "card_reach_distance_endgame " << search.card_reach_distance_endgame << "\n"
+                << "deck_rng " << to_string(search.deck_rng) << "\n"
+                << "population_size " << search.population_size << "\n"
+                << "num_elites " << search.num_elites << "\n"
+                << "sample_seed " << search.sample_seed << "\n"
+                << "generation " << state.generation << "\n"
+                << "reach_mean";
+            for (const double mean : state.reach_mean)
+            {
+                ofs << ' ' << mean;
+            }
+            ofs << "\nreach_stddev";
+            for (const double stddev : state.reach_stddev)
+            {
+                ofs << ' ' << stddev;
+            }
+            ofs << "\nskip_near_group_card_probability " << state.skip_near_group_card_probability << "\n"
+                << "best ";
+            write_params(ofs, state.best.params);
+            ofs << ' ' << state.best.cards_left_average << "\n"
+                << "population " << state.population.size() << "\n";
+            for (const auto &candidate : state.population)
+            {
+                write_params(ofs, candidate.params);
+                ofs << ' ' << candidate.cards_left_average << "\n";
+            }
+            if (!ofs.flush())
+            {
+                throw std::runtime_error("Can't write optimizer checkpoint: " + tmp_path);
+            }
+        }
+        if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+        {
+            throw std::runtime_error("Can't write optimizer checkpoint: " + path);
+        }
+    }
+
+    OptimizerState read_optimizer_checkpoint(const std::string &path, const OptimizerSearch &search)
+    {
+        std::ifstream ifs(path);
+        if (!ifs)
+        {
+            throw std::runtime_error("Can't open optimizer checkpoint: " + path);
+        }
+        std::string magic;
+        if (!(ifs >> magic) || magic != CHECKPOINT_MAGIC)
+        {
+            throw std::runtime_error("Not an optimizer checkpoint: " + path);
+        }
+        read_search_field(ifs, path, "num_players", search.num_players);
+        read_search_field(ifs, path, "num_trials", search.num_trials);
+        read_search_field(ifs, path, "card_reach_distance_normal", search.card_reach_distance_normal);
+        read_search_field(ifs, path, "card_reach_distance_endgame", search.card_reach_distance_endgame);
+        read_search_field(ifs, path, "deck_rng", to_string(search.deck_rng));
+        read_search_field(ifs, path, "population_size", search.population_size);
+        read_search_field(ifs, path, "num_elites", search.num_elites);
+        read_search_field(ifs, path, "sample_seed", search.sample_seed);
+
+        OptimizerState state;
+        auto &m = state.reach_mean;
+        auto &s = state.reach_stddev;
+        read_field(ifs, path, "generation", state.generation);
+        read_field(ifs, path, "reach_mean", m[0], m[1], m[2], m[3]);
+        read_field(ifs, path, "reach_stddev", s[0], s[1], s[2], s[3]);
+        read_field(ifs, path, "skip_near_group_card_probability", state.skip_near_group_card_probability);
+        std::string field;
+        if (!(ifs >> field) || field != "best" || !read_params(ifs, state.best.params) ||
+            !(ifs >> state.best.cards_left_average))
+        {
+            throw std::runtime_error("Bad optimizer checkpoint (best): " + path);
+        }
+        // A generation is always population_size candidates. Checked before
+        // allocating, so a bad count can't ask for all the memory.
+        size_t population_size = 0;
+        read_field(ifs, path, "population", population_size);
+        if (population_size != search.population_size)
+        {
+            throw std::runtime_error("Bad optimizer checkpoint (population): " + path);
+        }
+        state.population.resize(population_size);
+        for (auto &candidate : state.population)
+        {
+            if (!read_params(ifs, candidate.params) || !(ifs >> candidate.cards_left_average))
+            {
+                throw std::runtime_error("Bad optimizer checkpoint (population): " + path);
+            }
+        }
+        return state;
+    }
+
+    std::string to_string(const OptimizerResult &result)
+    {
+        std::ostringstream oss;
+        oss << "best: " << to_string(result.state.best.params) << "\n"
+            << "best (validation): " << to_string(result.best_validation) << "\n"
+            << "baseline (validation): " << to_string(result.baseline_validation) << "\n";
+        return oss.str();
+    }
+
+    OptimizerResult optimize_strategy(int num_players, int card_reach_distance_normal,
+                                      int card_reach_distance_endgame, uint64_t num_trials, bool do_parallel,
+                                      const OptimizerOptions &options, DeckRng deck_rng,
+                                      SchedulerOptions scheduler_options,
+                                      const std::function<void(const OptimizerState &)> &on_generation)
+    {
+        assert(num_trials >= MIN_TRIALS);
+        assert(num_trials <= MAX_TRIALS / 2 && "The validation seeds follow the training seeds");
+        assert(options.population_size >= 1);
+        assert(options.num_elites >= 1 && options.num_elites <= options.population_size);
+
+        StrategyParams baseline;
+        baseline.reach_schedule = make_reach_schedule(card_reach_distance_normal, card_reach_distance_endgame);
+        const OptimizerSearch search{num_players, num_trials, card_reach_distance_normal, card_reach_distance_endgame,
+                                     deck_rng, options.population_size, options.num_elites, options.sample_seed};
+
+        OptimizerState state;
+        if (!options.checkpoint_path.empty() && std::ifstream(options.checkpoint_path))
+        {
+            state = read_optimizer_checkpoint(options.checkpoint_path, search);
+            if (on_generation)
+            {
+                on_generation(state);
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < NUM_REACH_STAGES; ++i)
+            {
+                state.reach_mean[i] = baseline.reach_schedule.card_reach_distances[i];
+                state.reach_stddev[i] = INITIAL_REACH_STDDEV;
+            }
+        }
+
+        std::vector<StrategyParams> candidates;
+        while (state.generation < options.num_generations)
+        {
+            // Seeded by generation, so a resumed search samples what the whole one would have.
+            Xoshiro256 rng(options.sample_seed ^ (uint64_t{state.generation} * 0x9e3779b97f4a7c15));
+            candidates.clear();
+            for (unsigned i = 0; i < options.population_size; ++i)
+            {
+                candidates.push_back(state.generation == 0 && i == 0 ? baseline : sample_params(state, rng));
+            }
+            const auto results = play_candidates(num_players, candidates, 0, num_trials, do_parallel, deck_rng,
+                                                 scheduler_options);
+            state.population.clear();
+            for (size_t i = 0; i < candidates.size(); ++i)
+            {
+                state.population.push_back({candidates[i], results[i].cards_left_average});
+            }
+
+            std::vector<const OptimizerCandidate *> ranked;
+            for (const auto &candidate : state.population)
+            {
+                ranked.push_back(&candidate);
+            }
+            std::stable_sort(ranked.begin(), ranked.end(), [](const OptimizerCandidate *c1, const OptimizerCandidate *c2)
+                             { return c1->cards_left_average < c2->cards_left_average; });
+            if (state.generation == 0 || ranked.front()->cards_left_average < state.best.cards_left_average)
+            {
+                state.best = *ranked.front();
+            }
+            ranked.resize(options.num_elites);
+            update_distribution(state, ranked);
+            ++state.generation;
+
+            if (!options.checkpoint_path.empty())
+            {
+                write_optimizer_checkpoint(options.checkpoint_path, search, state);
+            }
+            if (on_generation)
+            {
+                on_generation(state);
+            }
+        }
+
+        OptimizerResult result;
+        result.state = state;
+        const auto validation = play_candidates(num_players, {state.best.params, baseline}, num_trials, num_trials,
+                                                do_parallel, deck_rng, scheduler_options);
+        result.best_validation = validation[0];
+        result.baseline_validation = validation[1];
+        return result;
+    }
+
+} // namespace TheGameAnalyzer
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "game.hpp"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace TheGameAnalyzer
+{
+    // Strategy parameters the optimizer searches over.
+    //
+    // There are no per-pile gap thresholds: the reach distance is applied
+    // inside the turn search and is part of the turn cache key, and a
+    // threshold per pile would add a runtime parameter to both.
+    struct StrategyParams
+    {
+        ReachSchedule reach_schedule;
+        bool skip_near_group_card{true}; // The 10-group rule: Strategy::Basic, else Strategy::ReachNearGroupCard.
+    };
+    bool operator==(const StrategyParams &p1, const StrategyParams &p2);
+
+    Strategy get_strategy(const StrategyParams &params);
+
+    std::string to_string(const StrategyParams &params);
+
+    struct OptimizerOptions
+    {
+        unsigned population_size{32}; // Candidates per generation.
+        unsigned num_elites{8};       // Best candidates the next generation is sampled around.
+        unsigned num_generations{20};
+        uint64_t sample_seed{0};      // Seed for sampling the candidates.
+        std::string checkpoint_path;  // If not empty, resume from this file and write it after each generation.
+    };
+
+    // A candidate and its average cards left over the training seeds.
+    struct OptimizerCandidate
+    {
+        StrategyParams params;
+        double cards_left_average{0.0};
+    };
+
+    // Cross-entropy search state: the distribution candidates are sampled
+    // from, the last generation and the best candidate so far.
+    struct OptimizerState
+    {
+        unsigned generation{0}; // Generations played.
+        std::array<double, NUM_REACH_STAGES> reach_mean{};
+        std::array<double, NUM_REACH_STAGES> reach_stddev{};
+        double skip_near_group_card_probability{0.5};
+        std::vector<OptimizerCandidate> population;
+        OptimizerCandidate best;
+    };
+
+    // One JSON line: the generation, the distribution and the best candidate.
+    std::string to_json(const OptimizerState &state);
+
+    // Everything a search's results depend on but its number of
+    // generations, so a checkpoint only resumes the same search.
+    struct OptimizerSearch
+    {
+        int num_players{1};
+        uint64_t num_trials{0};
+        int card_reach_distance_normal{0}; // The starting parameters.
+        int card_reach_distance_endgame{0};
+        DeckRng deck_rng{DeckRng::StdCompat};
+        unsigned population_size{0};
+        unsigned num_elites{0};
+        uint64_t sample_seed{0};
+    };
+
+    // Write the state to a checkpoint file, replacing it whole.
+    //
+    // Throws std::runtime_error if the file can't be written.
+    void write_optimizer_checkpoint(const std::string &path, const OptimizerSearch &search,
+                                    const OptimizerState &state);
+
+    // Read a checkpoint file written for the same search.
+    //
+    // Throws std::runtime_error if the file can't be read, is bad or is for another search.
+    OptimizerState read_optimizer_checkpoint(const std::string &path, const OptimizerSearch &search);
+
+    struct OptimizerResult
+    {
+        OptimizerState state;
+        TheGamesResults best_validation;     // The best candidate on the validation seeds.
+        TheGamesResults baseline_validation; // The starting parameters on the validation seeds.
+    };
+
+    std::string to_string(const OptimizerResult &result);
+
+    // Search strategy parameters with the cross-entropy method.
+    //
+    // Each generation samples population_size candidates (the first
+    // generation's first candidate is the starting parameters), plays every
+    // one on the same seeds [0, num_trials), and moves the distribution
+    // towards the num_elites that leave the fewest cards. The reach
+    // distances are normally distributed (rounded), and the 10-group rule is
+    // a coin flip. The candidates x seeds are played in parallel. The best
+    // candidate and the starting parameters are then played on the unseen
+    // seeds [num_trials, 2 * num_trials), so the result isn't just lucky on
+    // the training seeds.
+    //
+    // \param card_reach_distance_normal Starting reach distance, before the endgame.
+    // \param card_reach_distance_endgame Starting reach distance, during the endgame.
+    // \param on_generation If set, called after each generation (and after resuming).
+    // See play_games() for the other parameters.
+    OptimizerResult optimize_strategy(int num_players, int card_reach_distance_normal,
+                                      int card_reach_distance_endgame, uint64_t num_trials, bool do_parallel,
+                                      const OptimizerOptions &options, DeckRng deck_rng = DeckRng::StdCompat,
+                                      SchedulerOptions scheduler_options = {},
+                                      const std::function<void(const OptimizerState &)> &on_generation = {});
+
+} // namespace TheGameAnalyzer
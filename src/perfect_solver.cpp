@@ -0,0 +1,434 @@
+#include "perfect_solver.hpp"
+
+#include "card_set.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <memory>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+namespace TheGameAnalyzer
+{
+    namespace
+    {
+        const int MAX_SOLVER_PLAYERS = 2;
+        const int STARTING_MIN_CARDS_PER_TURN = 2;
+        const size_t MAX_CARDS_PER_HAND = calc_num_cards_per_hand(1);
+
+        // Transposition table entries (a power of 2), 16 bytes each.
+        const size_t TABLE_SIZE = size_t{1} << 20;
+
+        // Plays closer than this are tried before ending the turn.
+        const int END_TURN_DELTA = 2;
+
+        // Random keys for the parts of a position, the same for every solver.
+        struct ZobristKeys
+        {
+            std::array<std::array<uint64_t, 128>, MAX_SOLVER_PLAYERS> hands;
+            std::array<std::array<uint64_t, 128>, 4> piles; // Each direction's lower pile first.
+            std::array<uint64_t, NUM_CARDS_IN_DECK + 1> deck_pos;
+            std::array<uint64_t, MAX_SOLVER_PLAYERS> player;
+            std::array<uint64_t, STARTING_MIN_CARDS_PER_TURN + 1> turn_count;
+
+            ZobristKeys()
+            {
+                Xoshiro256 rng(0x5eed);
+                auto fill = [&](auto &keys)
+                {
+                    for (auto &key : keys)
+                    {
+                        key = rng();
+                    }
+                };
+                for (auto &keys : hands)
+                {
+                    fill(keys);
+                }
+                for (auto &keys : piles)
+                {
+                    fill(keys);
+                }
+                fill(deck_pos);
+                fill(player);
+                fill(turn_count);
+            }
+        };
+
+        const ZobristKeys &get_zobrist_keys()
+        {
+            static const ZobristKeys zobrist_keys;
+            return zobrist_keys;
+        }
+
+        struct State
+        {
+            Piles piles = {1, 1, 100, 100};
+            std::array<CardSet, MAX_SOLVER_PLAYERS> hands;
+            int deck_pos{0}; // Index of the next card to draw.
+            int player{0};
+            int turn_count{0}; // Cards played this turn, up to the minimum for the turn.
+            uint64_t hands_hash{0};
+        };
+
+        struct Move
+        {
+            int delta; // How far the card is from the pile, -10 for 10 back.
+            Card card;
+            int8_t piles_index; // -1 to end the turn.
+        };
+
+        struct TableEntry
+        {
+            uint64_t key{0};
+            int fail_threshold{-1}; // No line from here leaves at most this many cards.
+        };
+
+        class PerfectSolver
+        {
+        public:
+            PerfectSolver() : zobrist_keys_(get_zobrist_keys()), table_(TABLE_SIZE) {}
+
+            PerfectSolveResult solve(const ShuffledDeck &shuffled_deck, int num_players, int heuristic,
+                                     const PerfectSolverOptions &options);
+
+        private:
+            bool is_deck_empty(const State &state) const { return state.deck_pos == num_cards_in_deck_; }
+            int get_min_cards_for_turn(const State &state) const
+            {
+                return is_deck_empty(state) ? 1 : STARTING_MIN_CARDS_PER_TURN;
+            }
+            int get_num_cards_left(const State &state) const;
+            int get_lower_bound(const State &state) const;
+            uint64_t get_hash(const State &state) const;
+            void end_turn(State &state) const;
+            bool search(const State &state, int threshold);
+
+            const ZobristKeys &zobrist_keys_;
+            std::vector<TableEntry> table_;
+            std::array<Card, NUM_CARDS_IN_DECK> draw_order_{};
+            std::array<CardSet, NUM_CARDS_IN_DECK + 1> undrawn_; // Cards not drawn, by deck position.
+            int num_cards_in_deck_{0};
+            int num_players_{0};
+            int num_cards_per_hand_{0};
+            uint64_t max_nodes_{0};
+            bool use_lower_bound_{true};
+            uint64_t num_nodes_{0};
+            bool is_out_of_nodes_{false};
+            int best_{0};
+        };
+
+        int PerfectSolver::get_num_cards_left(const State &state) const
+        {
+            int num_cards_left = num_cards_in_deck_ - state.deck_pos;
+            for (int i = 0; i < num_players_; ++i)
+            {
+                num_cards_left += state.hands[i].size();
+            }
+            return num_cards_left;
+        }
+
+        int PerfectSolver::get_lower_bound(const State &state) const
+        {
+            CardSet alive = undrawn_[state.deck_pos];
+            for (int i = 0; i < num_players_; ++i)
+            {
+                alive = alive | state.hands[i];
+            }
+            return get_num_unreachable_cards(state.piles, alive);
+        }
+
+        uint64_t PerfectSolver::get_hash(const State &state) const
+        {
+            const auto &piles = state.piles;
+            const auto &keys = zobrist_keys_.piles;
+            return state.hands_hash ^
+                   keys[0][std::min(piles[0], piles[1])] ^ keys[1][std::max(piles[0], piles[1])] ^
+                   keys[2][std::min(piles[2], piles[3])] ^ keys[3][std::max(piles[2], piles[3])] ^
+                   zobrist_keys_.deck_pos[state.deck_pos] ^ zobrist_keys_.player[state.player] ^
+                   zobrist_keys_.turn_count[state.turn_count];
+        }
+
+        // Draw back up to a full hand and move on to the next hand with cards.
+        void PerfectSolver::end_turn(State &state) const
+        {
+            auto &hand = state.hands[state.player];
+            while (hand.size() < num_cards_per_hand_ && !is_deck_empty(state))
+            {
+                const Card card = draw_order_[state.deck_pos++];
+                hand.insert(card);
+                state.hands_hash ^= zobrist_keys_.hands[state.player][card];
+            }
+            const int next_player = state.player + 1 == num_players_ ? 0 : state.player + 1;
+            if (!state.hands[next_player].empty())
+            {
+                state.player = next_player;
+            }
+            state.turn_count = 0;
+        }
+
+        // \return true if a line leaves at most threshold cards, and sets best_ to its cards left.
+        bool PerfectSolver::search(const State &state, int threshold)
+        {
+            if (++num_nodes_ > max_nodes_)
+            {
+                is_out_of_nodes_ = true;
+                return false;
+            }
+            const int num_cards_left = get_num_cards_left(state);
+            if (num_cards_left == 0)
+            {
+                best_ = 0;
+                return true;
+            }
+            if (use_lower_bound_ && get_lower_bound(state) > threshold)
+            {
+                return false;
+            }
+            const uint64_t key = get_hash(state);
+            auto &entry = table_[key & (TABLE_SIZE - 1)];
+            if (entry.key == key && entry.fail_threshold >= threshold)
+            {
+                return false;
+            }
+
+            // Each card on each pile (once for equal piles of a direction), closest first.
+            std::array<Move, 4 * MAX_CARDS_PER_HAND + 1> moves;
+            size_t num_moves = 0;
+            const CardSet hand = state.hands[state.player];
+            for (int8_t i = 0; i < 4; ++i)
+            {
+                const Card pile = state.piles[i];
+                if ((i == 1 || i == 3) && pile == state.piles[i - 1])
+                {
+                    continue;
+                }
+                const bool is_ascending = i < 2;
+                CardSet cards = is_ascending ? hand.above(pile) : hand.below(pile);
+                const Card back = is_ascending ? pile - 10 : pile + 10;
+                if (back > 0 && hand.contains(back))
+                {
+                    moves[num_moves++] = {-10, back, i};
+                }
+                for (; !cards.empty(); cards.erase(cards.lowest()))
+                {
+                    const Card card = cards.lowest();
+                    moves[num_moves++] = {is_ascending ? card - pile : pile - card, card, i};
+                }
+            }
+            // A lone player with an empty deck just keeps playing: ending the turn changes nothing.
+            const bool can_end_turn = state.turn_count >= get_min_cards_for_turn(state) &&
+                                      !(num_players_ == 1 && is_deck_empty(state));
+            if (can_end_turn)
+            {
+                moves[num_moves++] = {END_TURN_DELTA, 0, -1};
+            }
+            std::stable_sort(moves.begin(), moves.begin() + num_moves,
+                             [](const Move &m1, const Move &m2)
+                             { return m1.delta < m2.delta; });
+
+            if (num_moves == 0)
+            {
+                // Stuck, the game is over.
+                if (num_cards_left <= threshold)
+                {
+                    best_ = num_cards_left;
+                    return true;
+                }
+            }
+            for (size_t m = 0; m < num_moves; ++m)
+            {
+                const auto &move = moves[m];
+                State child = state;
+                if (move.piles_index < 0)
+                {
+                    end_turn(child);
+                }
+                else
+                {
+                    child.piles[move.piles_index] = move.card;
+                    child.hands[child.player].erase(move.card);
+                    child.hands_hash ^= zobrist_keys_.hands[child.player][move.card];
+                    child.turn_count = std::min(child.turn_count + 1, get_min_cards_for_turn(child));
+                }
+                if (search(child, threshold))
+                {
+                    return true;
+                }
+                if (is_out_of_nodes_)
+                {
+                    return false;
+                }
+            }
+            entry = {key, std::max(threshold, entry.key == key ? entry.fail_threshold : -1)};
+            return false;
+        }
+
+        PerfectSolveResult PerfectSolver::solve(const ShuffledDeck &shuffled_deck, int num_players, int heuristic,
+                                                const PerfectSolverOptions &options)
+        {
+            assert(num_players >= MIN_PLAYERS && "Not enough players");
+            assert(num_players <= MAX_SOLVER_PLAYERS && "Too many players");
+            std::fill(table_.begin(), table_.end(), TableEntry{});
+            num_players_ = num_players;
+            num_cards_per_hand_ = static_cast<int>(calc_num_cards_per_hand(static_cast<size_t>(num_players)));
+            max_nodes_ = options.max_nodes;
+            use_lower_bound_ = options.use_lower_bound;
+            num_nodes_ = 0;
+            is_out_of_nodes_ = false;
+
+            ShuffledDeck deck = shuffled_deck;
+            num_cards_in_deck_ = static_cast<int>(deck.size());
+            for (int i = 0; i < num_cards_in_deck_; ++i)
+            {
+                draw_order_[i] = deck.draw();
+            }
+            undrawn_[num_cards_in_deck_] = CardSet();
+            for (int i = num_cards_in_deck_; i > 0; --i)
+            {
+                undrawn_[i - 1] = undrawn_[i];
+                undrawn_[i - 1].insert(draw_order_[i - 1]);
+            }
+
+            // Deal as play_game(), then any player may start.
+            State dealt;
+            for (int i = 0; i < num_players; ++i)
+            {
+                for (int c = 0; c < num_cards_per_hand_; ++c)
+                {
+                    const Card card = draw_order_[dealt.deck_pos++];
+                    dealt.hands[i].insert(card);
+                    dealt.hands_hash ^= zobrist_keys_.hands[i][card];
+                }
+            }
+            std::array<State, MAX_SOLVER_PLAYERS> roots;
+            for (int i = 0; i < num_players; ++i)
+            {
+                roots[i] = dealt;
+                roots[i].player = i;
+            }
+
+            PerfectSolveResult result;
+            result.heuristic = heuristic;
+            result.best = heuristic;
+            result.lower_bound = use_lower_bound_ ? get_lower_bound(dealt) : 0;
+            while (result.best > result.lower_bound)
+            {
+                const int threshold = result.best - 1;
+                bool is_found = false;
+                for (int i = 0; i < num_players && !is_found && !is_out_of_nodes_; ++i)
+                {
+                    is_found = search(roots[i], threshold);
+                }
+                if (is_out_of_nodes_)
+                {
+                    break;
+                }
+                if (!is_found)
+                {
+                    result.lower_bound = result.best;
+                    break;
+                }
+                assert(best_ <= threshold);
+                result.best = best_;
+            }
+            result.num_nodes = std::min(num_nodes_, max_nodes_);
+            return result;
+        }
+    } // namespace
+
+    // A pile only moves to cards still in the game, so a card is reachable
+    // from an ascending pile if it's above the pile, or 10 below the pile or
+    // a reachable card. Every pile seeds its own 10 back chain: the higher
+    // ascending pile can go back to a card the lower one can't reach (and
+    // the lower descending pile likewise).
+    int get_num_unreachable_cards(const Piles &piles, const CardSet &cards)
+    {
+        CardSet reach_ascending = cards.above(std::min(piles[0], piles[1]));
+        reach_ascending.insert(piles[0]);
+        reach_ascending.insert(piles[1]);
+        CardSet reach_descending = cards.below(std::max(piles[2], piles[3]));
+        reach_descending.insert(piles[2]);
+        reach_descending.insert(piles[3]);
+        for (;;)
+        {
+            const CardSet next_ascending = reach_ascending | (reach_ascending.shifted_down(10) & cards);
+            const CardSet next_descending = reach_descending | (reach_descending.shifted_up(10) & cards);
+            if (next_ascending == reach_ascending && next_descending == reach_descending)
+            {
+                break;
+            }
+            reach_ascending = next_ascending;
+            reach_descending = next_descending;
+        }
+        return (cards & ~(reach_ascending | reach_descending)).size();
+    }
+
+    PerfectSolveResult solve_perfect(const ShuffledDeck &deck, int num_players, int heuristic,
+                                     const PerfectSolverOptions &options)
+    {
+        PerfectSolver perfect_solver;
+        return perfect_solver.solve(deck, num_players, heuristic, options);
+    }
+
+    std::vector<PerfectSolveResult> solve_perfect_seeds(int num_players, int card_reach_distance_normal,
+                                                        int card_reach_distance_endgame, uint64_t num_trials,
+                                                        bool do_parallel, const PerfectSolverOptions &options,
+                                                        DeckRng deck_rng, const DeckCorpus *deck_corpus,
+                                                        SchedulerOptions scheduler_options)
+    {
+        assert(num_trials >= MIN_TRIALS);
+        assert(num_trials <= MAX_TRIALS);
+        assert(deck_corpus == nullptr || num_trials <= deck_corpus->size());
+        // A search is slow, so one seed per chunk keeps the threads balanced,
+        // up to MAX_NUM_CHUNKS chunks of consecutive seeds.
+        const uint64_t MAX_NUM_CHUNKS = 4096;
+        const uint64_t num_chunks = std::min(MAX_NUM_CHUNKS, num_trials);
+        if (!do_parallel)
+        {
+            scheduler_options = SchedulerOptions{1, false};
+        }
+        // One solver (and transposition table) per thread.
+        std::vector<std::unique_ptr<PerfectSolver>> perfect_solvers(get_num_threads(scheduler_options));
+        std::vector<PerfectSolveResult> results(num_trials);
+        auto solve_chunk = [&](uint64_t chunk_index, unsigned thread_index)
+        {
+            auto &perfect_solver = perfect_solvers[thread_index];
+            if (!perfect_solver)
+            {
+                perfect_solver = std::make_unique<PerfectSolver>();
+            }
+            const uint64_t first_seed = num_trials * chunk_index / num_chunks;
+            const uint64_t last_seed = num_trials * (chunk_index + 1) / num_chunks;
+            for (uint64_t seed = first_seed; seed < last_seed; ++seed)
+            {
+                const ShuffledDeck deck = deck_corpus != nullptr ? deck_corpus->get_deck(seed)
+                                                                 : ShuffledDeck(static_cast<uint32_t>(seed), deck_rng);
+                const int heuristic = play_game(deck, num_players, card_reach_distance_normal,
+                                                card_reach_distance_endgame);
+                results[seed] = perfect_solver->solve(deck, num_players, heuristic, options);
+                results[seed].seed = static_cast<uint32_t>(seed);
+            }
+        };
+        parallel_for_chunks(num_chunks, scheduler_options, solve_chunk);
+        return results;
+    }
+
+    std::string to_json(const std::vector<PerfectSolveResult> &results)
+    {
+        std::ostringstream oss;
+        for (const auto &result : results)
+        {
+            oss << "{ \"seed\": " << result.seed
+                << ", \"heuristic\": " << result.heuristic
+                << ", \"best\": " << result.best
+                << ", \"lower_bound\": " << result.lower_bound
+                << ", \"optimal\": " << (result.is_optimal() ? "true" : "false")
+                << ", \"num_nodes\": " << result.num_nodes << "}\n";
+        }
+        return oss.str();
+    }
+
+} // namespace TheGameAnalyzer
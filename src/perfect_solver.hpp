@@ -0,0 +1,75 @@
+#pragma once
+
+#include "card_set.hpp"
+#include "game.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace TheGameAnalyzer
+{
+    struct PerfectSolverOptions
+    {
+        // Search nodes per seed before giving up on proving the optimum.
+        uint64_t max_nodes{1000000};
+
+        // Prune with the lower bound. Off is much slower, for checking the bound.
+        bool use_lower_bound{true};
+    };
+
+    // Best result for one deck with every card known.
+    struct PerfectSolveResult
+    {
+        uint32_t seed{0};
+        int heuristic{0};   // Cards remaining for play_game().
+        int best{0};        // Fewest cards remaining found, at most heuristic.
+        int lower_bound{0}; // No line of play leaves fewer cards.
+        uint64_t num_nodes{0};
+
+        bool is_optimal() const { return best == lower_bound; }
+    };
+
+    // Cards that no pile can ever be played on, whatever the order: the
+    // search's lower bound on the cards remaining.
+    //
+    // \param piles Pile cards, ascending piles first.
+    // \param cards Cards still in the game (hands and deck).
+    int get_num_unreachable_cards(const Piles &piles, const CardSet &cards);
+
+    // Search for the fewest cards remaining when the whole deck order (and
+    // so every hand) is known, as a bound on what any strategy could do.
+    //
+    // The search plays one card at a time, with ending the turn (and drawing)
+    // as a move of its own once enough cards are played, and the players may
+    // pick who starts. Each pass is a depth first search for a line leaving
+    // at most a threshold of cards, starting one below the heuristic and
+    // tightening after every line found, until a pass fails (best is optimal)
+    // or max_nodes runs out. Lines are pruned with an admissible lower bound
+    // (cards no pile can reach any more, 10 back chains included) and a
+    // transposition table of Zobrist hashes of the piles, hands, deck
+    // position, player and cards played this turn. (A 64 bit hash collision
+    // could wrongly prune a line, which is rare enough to ignore here.)
+    //
+    // \param deck Shuffled deck, before the hands are dealt.
+    // \param num_players Number of players in the game (1-2).
+    // \param heuristic Cards remaining for play_game(), the starting best.
+    // \return Result with seed 0.
+    PerfectSolveResult solve_perfect(const ShuffledDeck &deck, int num_players, int heuristic,
+                                     const PerfectSolverOptions &options);
+
+    // solve_perfect() each seed [0, num_trials), next to play_game() with the
+    // given reach distances. The seeds run in parallel.
+    //
+    // See play_games() for the parameters.
+    std::vector<PerfectSolveResult> solve_perfect_seeds(int num_players, int card_reach_distance_normal,
+                                                        int card_reach_distance_endgame, uint64_t num_trials,
+                                                        bool do_parallel, const PerfectSolverOptions &options,
+                                                        DeckRng deck_rng = DeckRng::StdCompat,
+                                                        const DeckCorpus *deck_corpus = nullptr,
+                                                        SchedulerOptions scheduler_options = {});
+
+    // JSON, one object per seed.
+    std::string to_json(const std::vector<PerfectSolveResult> &results);
+
+} // namespace TheGameAnalyzer
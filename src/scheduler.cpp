@@ -0,0 +1,167 @@
+#include "scheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace TheGameAnalyzer
+{
+    namespace
+    {
+        // Chunks [first, last) a thread has left, in one word so the owner
+        // and thieves can both change it with a compare and swap.
+        //
+        // (No ABA problem: a non-empty range holds its first chunk, and a
+        // taken chunk is never given back, so a range can't come back once
+        // changed. Empty ranges are never swapped.)
+        class alignas(64) ChunkRange
+        {
+        public:
+            void set(uint32_t first, uint32_t last)
+            {
+                range_.store(pack(first, last), std::memory_order_release);
+            }
+
+            // Owner: take the first chunk.
+            bool pop(uint32_t &chunk_index)
+            {
+                uint64_t range = range_.load(std::memory_order_acquire);
+                while (get_first(range) < get_last(range))
+                {
+                    if (range_.compare_exchange_weak(range, pack(get_first(range) + 1, get_last(range)),
+                                                     std::memory_order_acq_rel))
+                    {
+                        chunk_index = get_first(range);
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            // Thief: take the back half (rounded up).
+            bool steal(uint32_t &first, uint32_t &last)
+            {
+                uint64_t range = range_.load(std::memory_order_acquire);
+                while (get_first(range) < get_last(range))
+                {
+                    const uint32_t middle = get_first(range) + (get_last(range) - get_first(range)) / 2;
+                    if (range_.compare_exchange_weak(range, pack(get_first(range), middle),
+                                                     std::memory_order_acq_rel))
+                    {
+                        first = middle;
+                        last = get_last(range);
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+        private:
+            static uint64_t pack(uint32_t first, uint32_t last) { return (uint64_t{first} << 32) | last; }
+            static uint32_t get_first(uint64_t range) { return static_cast<uint32_t>(range >> 32); }
+            static uint32_t get_last(uint64_t range) { return static_cast<uint32_t>(range); }
+
+            std::atomic<uint64_t> range_{0};
+        };
+
+        void pin_thread(std::thread &thread, unsigned thread_index)
+        {
+#ifdef __linux__
+            const unsigned num_cores = std::max(1u, std::thread::hardware_concurrency());
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(thread_index % num_cores, &cpu_set);
+            pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set);
+#else
+            (void)thread;
+            (void)thread_index;
+#endif
+        }
+    } // namespace
+
+    unsigned get_num_threads(const SchedulerOptions &options)
+    {
+        if (options.num_threads > 0)
+        {
+            return options.num_threads;
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    void parallel_for_chunks(uint64_t num_chunks, const SchedulerOptions &options,
+                             const std::function<void(uint64_t, unsigned)> &fn)
+    {
+        assert(num_chunks <= UINT32_MAX);
+        const unsigned num_threads = get_num_threads(options);
+        if (num_threads == 1 && !options.pin_threads)
+        {
+            for (uint64_t chunk_index = 0; chunk_index < num_chunks; ++chunk_index)
+            {
+                fn(chunk_index, 0);
+            }
+            return;
+        }
+
+        const auto ranges = std::make_unique<ChunkRange[]>(num_threads);
+        for (unsigned i = 0; i < num_threads; ++i)
+        {
+            ranges[i].set(static_cast<uint32_t>(num_chunks * i / num_threads),
+                          static_cast<uint32_t>(num_chunks * (i + 1) / num_threads));
+        }
+        auto run = [&](unsigned thread_index)
+        {
+            auto &own = ranges[thread_index];
+            while (true)
+            {
+                uint32_t chunk_index = 0;
+                if (own.pop(chunk_index))
+                {
+                    fn(chunk_index, thread_index);
+                    continue;
+                }
+                // Out of work, steal from the next thread along that has some.
+                // (If every thread is out, we're done. A range being moved by
+                // another thief still gets done by that thief.)
+                bool is_stolen = false;
+                for (unsigned k = 1; k < num_threads && !is_stolen; ++k)
+                {
+                    uint32_t first = 0;
+                    uint32_t last = 0;
+                    if (ranges[(thread_index + k) % num_threads].steal(first, last))
+                    {
+                        own.set(first, last);
+                        is_stolen = true;
+                    }
+                }
+                if (!is_stolen)
+                {
+                    return;
+                }
+            }
+        };
+
+        // (All the work is on new threads so pinning doesn't change the caller.)
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < num_threads; ++i)
+        {
+            threads.emplace_back(run, i);
+            if (options.pin_threads)
+            {
+                pin_thread(threads.back(), i);
+            }
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+} // namespace TheGameAnalyzer
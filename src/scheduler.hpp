@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace TheGameAnalyzer
+{
+    struct SchedulerOptions
+    {
+        unsigned num_threads{0}; // 0 for one per hardware thread.
+        bool pin_threads{false}; // Pin thread i to core i (mod the number of cores). Linux only.
+    };
+
+    // Number of threads parallel_for_chunks() runs with these options.
+    unsigned get_num_threads(const SchedulerOptions &options);
+
+    // Call fn(chunk_index, thread_index) once for every chunk_index in
+    // [0, num_chunks), on get_num_threads(options) threads.
+    //
+    // Each thread starts with an equal, contiguous share of the chunks and
+    // takes them from the front. A thread that runs out steals the back half
+    // of another thread's share. thread_index is in [0, get_num_threads()),
+    // so callers can keep their own state for each thread. With one thread
+    // (and no pinning) fn runs on the calling thread in chunk order.
+    void parallel_for_chunks(uint64_t num_chunks, const SchedulerOptions &options,
+                             const std::function<void(uint64_t, unsigned)> &fn);
+
+} // namespace TheGameAnalyzer
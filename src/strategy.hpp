@@ -0,0 +1,186 @@
+#pragma once
+
+#include "card_set.hpp"
+#include "turn.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace TheGameAnalyzer
+{
+    // Heuristics the game can be played with.
+    enum class Strategy
+    {
+        Basic,                  // The README's basic strategy.
+        NoDeltaTiebreak,        // Basic without tiebreaker 2 (smaller delta).
+        NoGroupReachTiebreak,   // Basic without tiebreaker 3 (didn't reach for a group).
+        NoMoreCardsTiebreak,    // Basic without tiebreaker 4 (more cards).
+        NoPileExtremesTiebreak, // Basic without tiebreaker 5 (keep the pile extremes).
+        ReachNearGroupCard,     // Basic, but reach for the near card of a 10-group too.
+        FirstHandStarts,        // Basic, but the first hand starts instead of the strongest.
+        CardMemory,             // Basic, but jumping over cards already played is free.
+    };
+    const size_t NUM_STRATEGIES = 8;
+
+    std::string to_string(Strategy);
+
+    // \return The strategy named by to_string(), if any.
+    std::optional<Strategy> parse_strategy(const std::string &name);
+
+    // Strategy policies.
+    //
+    // A policy is a struct of compile-time choices that the turn search and
+    // the game loop take as a template parameter, so a strategy costs nothing
+    // per turn. BasicStrategy is the README's basic strategy, and the others
+    // each change one of its choices.
+    struct BasicStrategy
+    {
+        static constexpr Strategy strategy = Strategy::Basic;
+
+        // Turn ordering: tiebreakers 2-5 of TurnCompare. (Tiebreaker 1, the
+        // minimum number of cards, is a rule of the game.)
+        static constexpr bool prefer_smaller_delta = true;
+        static constexpr bool prefer_no_group_reach = true;
+        static constexpr bool prefer_more_cards = true;
+        static constexpr bool prefer_pile_extremes = true;
+
+        // Reach: don't reach for the near card of a 10-group.
+        static constexpr bool skip_near_group_card = true;
+
+        // Starting hand: the one with the best first turn, else the first hand.
+        static constexpr bool choose_starting_hand = true;
+
+        // Memory: don't count the cards already played that a play jumps over
+        // in its delta. (The README's strategy has no memory.)
+        static constexpr bool remember_played_cards = false;
+    };
+
+    struct NoDeltaTiebreakStrategy : BasicStrategy
+    {
+        static constexpr Strategy strategy = Strategy::NoDeltaTiebreak;
+        static constexpr bool prefer_smaller_delta = false;
+    };
+
+    struct NoGroupReachTiebreakStrategy : BasicStrategy
+    {
+        static constexpr Strategy strategy = Strategy::NoGroupReachTiebreak;
+        static constexpr bool prefer_no_group_reach = false;
+    };
+
+    struct NoMoreCardsTiebreakStrategy : BasicStrategy
+    {
+        static constexpr Strategy strategy = Strategy::NoMoreCardsTiebreak;
+        static constexpr bool prefer_more_cards = false;
+    };
+
+    struct NoPileExtremesTiebreakStrategy : BasicStrategy
+    {
+        static constexpr Strategy strategy = Strategy::NoPileExtremesTiebreak;
+        static constexpr bool prefer_pile_extremes = false;
+    };
+
+    struct ReachNearGroupCardStrategy : BasicStrategy
+    {
+        static constexpr Strategy strategy = Strategy::ReachNearGroupCard;
+        static constexpr bool skip_near_group_card = false;
+    };
+
+    struct FirstHandStartsStrategy : BasicStrategy
+    {
+        static constexpr Strategy strategy = Strategy::FirstHandStarts;
+        static constexpr bool choose_starting_hand = false;
+    };
+
+    struct CardMemoryStrategy : BasicStrategy
+    {
+        static constexpr Strategy strategy = Strategy::CardMemory;
+        static constexpr bool remember_played_cards = true;
+    };
+
+    // Call f with the policy of strategy (a default constructed StrategyPolicy).
+    //
+    // This is the only place a strategy is looked up at run time, so call it
+    // once per game (or forked game), outside the turn loop.
+    template <typename F>
+    decltype(auto) visit_strategy(Strategy strategy, F &&f)
+    {
+        switch (strategy)
+        {
+        case Strategy::Basic:
+            break;
+        case Strategy::NoDeltaTiebreak:
+            return f(NoDeltaTiebreakStrategy{});
+        case Strategy::NoGroupReachTiebreak:
+            return f(NoGroupReachTiebreakStrategy{});
+        case Strategy::NoMoreCardsTiebreak:
+            return f(NoMoreCardsTiebreakStrategy{});
+        case Strategy::NoPileExtremesTiebreak:
+            return f(NoPileExtremesTiebreakStrategy{});
+        case Strategy::ReachNearGroupCard:
+            return f(ReachNearGroupCardStrategy{});
+        case Strategy::FirstHandStarts:
+            return f(FirstHandStartsStrategy{});
+        case Strategy::CardMemory:
+            return f(CardMemoryStrategy{});
+        }
+        assert(strategy == Strategy::Basic);
+        return f(BasicStrategy{});
+    }
+
+    // TurnCompare under a strategy policy.
+    template <typename StrategyPolicy>
+    struct StrategyTurnCompare
+    {
+        int min_cards_for_turn;
+
+        // \return true if t2 is better than t1.
+        bool operator()(const Turn &t1, const Turn &t2) const
+        {
+            const int t1_num_cards = get_num_cards_in_hand_mask(t1.hand_mask);
+            const int t2_num_cards = get_num_cards_in_hand_mask(t2.hand_mask);
+            const bool t1_has_min_cards = t1_num_cards >= min_cards_for_turn;
+            const bool t2_has_min_cards = t2_num_cards >= min_cards_for_turn;
+            if (t1_has_min_cards != t2_has_min_cards)
+            {
+                // 1. Prefer minimum number of cards played.
+                return t2_has_min_cards;
+            }
+            if (StrategyPolicy::prefer_smaller_delta && t1.delta != t2.delta)
+            {
+                // 2. Prefer smaller delta.
+                return t2.delta < t1.delta;
+            }
+            if (StrategyPolicy::prefer_no_group_reach && t1.reached_for_group != t2.reached_for_group)
+            {
+                // 3. Prefer the plays that didn't reach for a group.
+                return t1.reached_for_group;
+            }
+            if (StrategyPolicy::prefer_more_cards && t1_num_cards != t2_num_cards)
+            {
+                // 4. Prefer the turn that used more cards.
+                return t2_num_cards > t1_num_cards;
+            }
+            if (StrategyPolicy::prefer_pile_extremes)
+            {
+                // 5. Prefer to keep the numbers on the extreme intact.
+                auto get_sum_of_pile_extremes = [](const Piles &piles)
+                { return std::min(piles[0], piles[1]) - std::max(piles[2], piles[3]); };
+                return get_sum_of_pile_extremes(t2.piles) < get_sum_of_pile_extremes(t1.piles);
+            }
+            return false;
+        }
+    };
+
+    // find_best_turn() under a strategy policy.
+    //
+    // \param played_cards Cards played so far in the game, only used if the
+    //                     strategy remembers them.
+    template <typename StrategyPolicy>
+    Turn find_best_turn(const Piles &, const Hand &, const CardSet &played_cards,
+                        int min_cards_for_turn,
+                        int card_reach_distance);
+
+} // namespace TheGameAnalyzer
@@ -0,0 +1,492 @@
+#include "sweep.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include <sstream>
+
+namespace TheGameAnalyzer
+{
+    // Reach distance configurations with the endgame one at least the normal one.
+    static std::vector<CardReachDistances> get_configs(SweepRange card_reach_distance_normal,
+                                                       SweepRange card_reach_distance_endgame)
+    {
+        std::vector<CardReachDistances> configs;
+        for (int r = card_reach_distance_normal.first; r <= card_reach_distance_normal.last; ++r)
+        {
+            for (int e = std::max(r, card_reach_distance_endgame.first); e <= card_reach_distance_endgame.last; ++e)
+            {
+                configs.push_back({r, e});
+            }
+        }
+        return configs;
+    }
+
+    static ShuffledDeck get_deck(uint64_t seed, DeckRng deck_rng, const DeckCorpus *deck_corpus)
+    {
+        if (deck_corpus != nullptr)
+        {
+            return deck_corpus->get_deck(seed);
+        }
+        return ShuffledDeck(static_cast<uint32_t>(seed), deck_rng);
+    }
+
+    std::vector<SweepCell> play_sweep(SweepRange num_players, SweepRange card_reach_distance_normal,
+                                      SweepRange card_reach_distance_endgame, uint64_t num_trials,
+                                      bool do_parallel, TurnEngine turn_engine, DeckRng deck_rng,
+                                      const DeckCorpus *deck_corpus, SchedulerOptions scheduler_options)
+    {
+        assert(num_trials >= MIN_TRIALS);
+        assert(num_trials <= MAX_TRIALS);
+        assert(deck_corpus == nullptr || num_trials <= deck_corpus->size());
+        std::vector<SweepCell> cells;
+        for (int n = num_players.first; n <= num_players.last; ++n)
+        {
+            for (const auto &config : get_configs(card_reach_distance_normal, card_reach_distance_endgame))
+            {
+                cells.push_back({n, config.normal, config.endgame, {}});
+            }
+        }
+
+        // Each number of players plays all its cells in one forked game per deck.
+        struct PlayerCells
+        {
+            int num_players;
+            size_t first; // Range of cells.
+            size_t last;
+        };
+        std::vector<PlayerCells> players_cells;
+        std::vector<CardReachDistances> configs;
+        for (size_t i = 0; i < cells.size(); ++i)
+        {
+            if (players_cells.empty() || players_cells.back().num_players != cells[i].num_players)
+            {
+                players_cells.push_back({cells[i].num_players, i, i});
+            }
+            ++players_cells.back().last;
+            configs.push_back({cells[i].card_reach_distance_normal, cells[i].card_reach_distance_endgame});
+        }
+
+        // Seeds [0, num_trials) are split into at most MAX_NUM_CHUNKS chunks
+        // for the scheduler. Each thread has its own stats for every cell, and
+        // its own scratch for a deck's results.
+        const uint64_t MIN_CHUNK_SIZE = 16;
+        const uint64_t MAX_NUM_CHUNKS = 1024;
+        const uint64_t num_chunks = std::min(MAX_NUM_CHUNKS, (num_trials + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE);
+        if (!do_parallel)
+        {
+            scheduler_options = SchedulerOptions{1, false};
+        }
+        struct ThreadState
+        {
+            std::vector<GamesStats> cells_stats;
+            std::vector<int> num_cards_remaining;
+        };
+        std::vector<ThreadState> thread_states(get_num_threads(scheduler_options));
+        for (auto &thread_state : thread_states)
+        {
+            thread_state.cells_stats.resize(cells.size());
+            thread_state.num_cards_remaining.resize(cells.size());
+        }
+        auto play_chunk = [&](uint64_t chunk_index, unsigned thread_index)
+        {
+            auto &[cells_stats, num_cards_remaining] = thread_states[thread_index];
+            const uint64_t first_seed = num_trials * chunk_index / num_chunks;
+            const uint64_t last_seed = num_trials * (chunk_index + 1) / num_chunks;
+            for (uint64_t seed = first_seed; seed < last_seed; ++seed)
+            {
+                const ShuffledDeck deck = get_deck(seed, deck_rng, deck_corpus);
+                for (const auto &player_cells : players_cells)
+                {
+                    play_game_forked(deck, player_cells.num_players, configs.data() + player_cells.first,
+                                     player_cells.last - player_cells.first, turn_engine,
+                                     num_cards_remaining.data() + player_cells.first);
+                }
+                for (size_t i = 0; i < cells.size(); ++i)
+                {
+                    cells_stats[i].add(num_cards_remaining[i]);
+                }
+            }
+        };
+        parallel_for_chunks(num_chunks, scheduler_options, play_chunk);
+        std::vector<GamesStats> cells_stats(cells.size());
+        for (const auto &thread_state : thread_states)
+        {
+            for (size_t i = 0; i < cells.size(); ++i)
+            {
+                cells_stats[i].merge(thread_state.cells_stats[i]);
+            }
+        }
+        for (size_t i = 0; i < cells.size(); ++i)
+        {
+            cells[i].results = calculate_games_stats(cells_stats[i]);
+        }
+        return cells;
+    }
+
+    std::string to_json(const std::vector<SweepCell> &cells)
+    {
+        std::ostringstream oss;
+        for (const auto &cell : cells)
+        {
+            oss << "{ \"num_players\": " << cell.num_players
+                << ", \"card_reach_distance\": " << cell.card_reach_distance_normal
+                << ", \"card_reach_distance_endgame\": " << cell.card_reach_distance_endgame
+                << ", \"results\": " << to_string(cell.results) << "}\n";
+        }
+        return oss.str();
+    }
+
+    static void print_table(std::ostringstream &oss, const std::vector<const SweepCell *> &cells,
+                            const std::string &title, double TheGamesResults::*percent)
+    {
+        int r_first = cells.front()->card_reach_distance_normal;
+        int r_last = r_first;
+        int e_first = cells.front()->card_reach_distance_endgame;
+        int e_last = e_first;
+        for (const auto *cell : cells)
+        {
+            r_first = std::min(r_first, cell->card_reach_distance_normal);
+            r_last = std::max(r_last, cell->card_reach_distance_normal);
+            e_first = std::min(e_first, cell->card_reach_distance_endgame);
+            e_last = std::max(e_last, cell->card_reach_distance_endgame);
+        }
+        const int num_players = cells.front()->num_players;
+        oss << "## " << num_players << " player" << (num_players > 1 ? "s" : "") << ": " << title << "\n\n";
+        oss << "| reach distance (normal →) |";
+        for (int r = r_first; r <= r_last; ++r)
+        {
+            oss << " " << r << " |";
+        }
+        oss << "\n|---|";
+        for (int r = r_first; r <= r_last; ++r)
+        {
+            oss << "---|";
+        }
+        oss << "\n| reach distance (endgame ↓) |";
+        for (int r = r_first; r <= r_last; ++r)
+        {
+            oss << " |";
+        }
+        oss << "\n";
+        for (int e = e_first; e <= e_last; ++e)
+        {
+            oss << "| " << e << " |";
+            for (int r = r_first; r <= r_last; ++r)
+            {
+                const auto it = std::find_if(cells.begin(), cells.end(), [=](const SweepCell *cell)
+                                             { return cell->card_reach_distance_normal == r &&
+                                                      cell->card_reach_distance_endgame == e; });
+                if (it == cells.end())
+                {
+                    oss << "   |";
+                }
+                else
+                {
+                    oss << " " << (*it)->results.*percent << " |";
+                }
+            }
+            oss << "\n";
+        }
+        oss << "\n";
+    }
+
+    std::string to_markdown(const std::vector<SweepCell> &cells)
+    {
+        std::ostringstream oss;
+        for (size_t first = 0; first < cells.size();)
+        {
+            std::vector<const SweepCell *> player_cells;
+            size_t last = first;
+            for (; last < cells.size() && cells[last].num_players == cells[first].num_players; ++last)
+            {
+                player_cells.push_back(&cells[last]);
+            }
+            print_table(oss, player_cells, "excellent game percentage (less than 10 cards remaining)",
+                        &TheGamesResults::excellent_percent);
+            print_table(oss, player_cells, "beat the game percentage (0 cards remaining)",
+                        &TheGamesResults::beat_the_game_percent);
+            first = last;
+        }
+        return oss.str();
+    }
+
+    // z with P(|Z| <= z) = confidence for a standard normal Z.
+    static double get_two_sided_z(double confidence)
+    {
+        double lo = 0.0;
+        double hi = 40.0;
+        for (int i = 0; i < 100; ++i)
+        {
+            const double z = (lo + hi) / 2.0;
+            if (std::erfc(z / std::sqrt(2.0)) > 1.0 - confidence)
+            {
+                lo = z;
+            }
+            else
+            {
+                hi = z;
+            }
+        }
+        return (lo + hi) / 2.0;
+    }
+
+    RaceResult play_race(int num_players, SweepRange card_reach_distance_normal,
+                         SweepRange card_reach_distance_endgame, uint64_t max_trials, double confidence,
+                         bool do_parallel, TurnEngine turn_engine, DeckRng deck_rng, const DeckCorpus *deck_corpus,
+                         SchedulerOptions scheduler_options)
+    {
+        assert(max_trials >= MIN_TRIALS);
+        assert(max_trials <= MAX_TRIALS);
+        assert(deck_corpus == nullptr || max_trials <= deck_corpus->size());
+        assert(confidence > 0.0 && confidence < 1.0);
+        if (!do_parallel)
+        {
+            scheduler_options = SchedulerOptions{1, false};
+        }
+        const auto configs = get_configs(card_reach_distance_normal, card_reach_distance_endgame);
+        const size_t num_configs = configs.size();
+
+        // Bonferroni correction: every round compares up to every other
+        // configuration with the leader.
+        uint64_t num_rounds = 0;
+        for (uint64_t n = 0; n < max_trials; n += std::min(max_trials - n, n == 0 ? RACE_FIRST_ROUND_TRIALS : n))
+        {
+            ++num_rounds;
+        }
+        const double num_comparisons = static_cast<double>(std::max<size_t>(num_configs, 2) - 1) *
+                                       static_cast<double>(num_rounds);
+        const double comparison_confidence = 1.0 - (1.0 - confidence) / num_comparisons;
+        const double z = get_two_sided_z(comparison_confidence);
+
+        RaceResult race_result;
+        race_result.num_players = num_players;
+        race_result.confidence = confidence;
+        race_result.comparison_confidence = comparison_confidence;
+        race_result.num_games_full_grid = num_configs * max_trials;
+        if (num_configs == 0)
+        {
+            return race_result;
+        }
+        race_result.cells.resize(num_configs);
+        for (size_t i = 0; i < num_configs; ++i)
+        {
+            race_result.cells[i].card_reach_distance_normal = configs[i].normal;
+            race_result.cells[i].card_reach_distance_endgame = configs[i].endgame;
+        }
+
+        // Exact sums over the seeds played by every live configuration: cards
+        // left, and cards left times cards left of each other configuration
+        // (so any two can be compared paired, whichever is the leader).
+        std::vector<uint64_t> sums(num_configs);
+        std::vector<uint64_t> sums_of_products(num_configs * num_configs);
+        std::vector<size_t> live(num_configs); // Indexes of configurations not dropped.
+        std::iota(live.begin(), live.end(), 0);
+        uint64_t num_trials = 0;
+
+        // Paired difference of configuration i from j so far.
+        auto get_diff = [&](size_t i, size_t j, double &diff, double &half_width)
+        {
+            const double n = static_cast<double>(num_trials);
+            diff = (static_cast<double>(sums[i]) - static_cast<double>(sums[j])) / n;
+            const double sum_of_squares = static_cast<double>(sums_of_products[i * num_configs + i]) +
+                                          static_cast<double>(sums_of_products[j * num_configs + j]) -
+                                          2.0 * static_cast<double>(sums_of_products[i * num_configs + j]);
+            const double variance = n > 1.0 ? std::max(0.0, (sum_of_squares - n * diff * diff) / (n - 1.0)) : 0.0;
+            half_width = z * std::sqrt(variance / n);
+            return sum_of_squares;
+        };
+        auto set_cell = [&](size_t i, size_t leader, RaceCellStatus status)
+        {
+            auto &cell = race_result.cells[i];
+            cell.status = status;
+            cell.num_trials = num_trials;
+            cell.cards_left_average = static_cast<double>(sums[i]) / static_cast<double>(num_trials);
+            get_diff(i, leader, cell.cards_left_diff, cell.cards_left_diff_half_width);
+        };
+
+        size_t leader = 0;
+        while (num_trials < max_trials && (num_trials == 0 || live.size() > 1))
+        {
+            const uint64_t round_size = std::min(max_trials - num_trials,
+                                                 num_trials == 0 ? RACE_FIRST_ROUND_TRIALS : num_trials);
+            std::vector<CardReachDistances> live_configs;
+            for (const auto i : live)
+            {
+                live_configs.push_back(configs[i]);
+            }
+            // Rounds double, so a round is played a block of seeds at a time to
+            // keep the scratch bounded. One seed per chunk, since each seed is
+            // a forked game for every live configuration.
+            const uint64_t BLOCK_SIZE = 1024;
+            std::vector<int> num_cards_remaining(std::min(round_size, BLOCK_SIZE) * live.size());
+            for (uint64_t first = 0; first < round_size; first += BLOCK_SIZE)
+            {
+                const uint64_t block_size = std::min(BLOCK_SIZE, round_size - first);
+                parallel_for_chunks(block_size, scheduler_options, [&](uint64_t k, unsigned)
+                                    { play_game_forked(get_deck(num_trials + first + k, deck_rng, deck_corpus),
+                                                       num_players, live_configs.data(), live_configs.size(),
+                                                       turn_engine, num_cards_remaining.data() + k * live.size()); });
+                for (uint64_t k = 0; k < block_size; ++k)
+                {
+                    const int *x = num_cards_remaining.data() + k * live.size();
+                    for (size_t a = 0; a < live.size(); ++a)
+                    {
+                        sums[live[a]] += static_cast<uint64_t>(x[a]);
+                        for (size_t b = a; b < live.size(); ++b)
+                        {
+                            const uint64_t product = static_cast<uint64_t>(x[a] * x[b]);
+                            sums_of_products[live[a] * num_configs + live[b]] += product;
+                            if (b != a)
+                            {
+                                sums_of_products[live[b] * num_configs + live[a]] += product;
+                            }
+                        }
+                    }
+                }
+            }
+            num_trials += round_size;
+            race_result.num_games += round_size * live.size();
+
+            leader = *std::min_element(live.begin(), live.end(), [&](size_t i, size_t j)
+                                       { return sums[i] < sums[j]; });
+            std::vector<size_t> next_live;
+            for (const auto i : live)
+            {
+                if (i == leader)
+                {
+                    next_live.push_back(i);
+                    continue;
+                }
+                double diff = 0.0;
+                double half_width = 0.0;
+                const double sum_of_squares = get_diff(i, leader, diff, half_width);
+                if (sum_of_squares == 0.0)
+                {
+                    set_cell(i, leader, RaceCellStatus::Tied);
+                }
+                else if (diff - half_width > 0.0)
+                {
+                    set_cell(i, leader, RaceCellStatus::Dominated);
+                }
+                else
+                {
+                    next_live.push_back(i);
+                }
+            }
+            live = next_live;
+        }
+        for (const auto i : live)
+        {
+            set_cell(i, leader, i == leader ? RaceCellStatus::Winner : RaceCellStatus::Contender);
+        }
+
+        // (Dropped configurations' averages are over fewer trials, so order by difference from the leader.)
+        std::stable_sort(race_result.cells.begin(), race_result.cells.end(), [](const RaceCell &c1, const RaceCell &c2)
+                         { return std::make_pair(c1.status, c1.cards_left_diff) < std::make_pair(c2.status, c2.cards_left_diff); });
+        return race_result;
+    }
+
+    std::string to_string(RaceCellStatus status)
+    {
+        switch (status)
+        {
+        case RaceCellStatus::Winner:
+            return "winner";
+        case RaceCellStatus::Contender:
+            return "contender";
+        case RaceCellStatus::Dominated:
+            return "dominated";
+        case RaceCellStatus::Tied:
+            return "tied";
+        }
+        assert(false);
+        return "";
+    }
+
+    std::string to_string(const RaceResult &race_result)
+    {
+        std::ostringstream oss;
+        oss << "{ \"num_players\": " << race_result.num_players
+            << ", \"confidence\": " << race_result.confidence
+            << ", \"comparison_confidence\": " << race_result.comparison_confidence
+            << ", \"num_games\": " << race_result.num_games
+            << ", \"num_games_full_grid\": " << race_result.num_games_full_grid
+            << ", \"cells\": [\n";
+        for (size_t i = 0; i < race_result.cells.size(); ++i)
+        {
+            const auto &cell = race_result.cells[i];
+            oss << "  { \"card_reach_distance\": " << cell.card_reach_distance_normal
+                << ", \"card_reach_distance_endgame\": " << cell.card_reach_distance_endgame
+                << ", \"status\": \"" << to_string(cell.status) << "\""
+                << ", \"num_trials\": " << cell.num_trials
+                << ", \"cards_left_average\": " << cell.cards_left_average
+                << ", \"cards_left_diff\": " << cell.cards_left_diff
+                << ", \"cards_left_diff_half_width\": " << cell.cards_left_diff_half_width
+                << "}" << (i + 1 < race_result.cells.size() ? "," : "") << "\n";
+        }
+        oss << "]}\n";
+        return oss.str();
+    }
+
+    std::vector<StrategyCell> play_strategies(int num_players, int card_reach_distance_normal,
+                                              int card_reach_distance_endgame,
+                                              const std::vector<Strategy> &strategies, uint64_t num_trials,
+                                              bool do_parallel, DeckRng deck_rng, const DeckCorpus *deck_corpus,
+                                              SchedulerOptions scheduler_options)
+    {
+        assert(num_trials >= MIN_TRIALS);
+        assert(num_trials <= MAX_TRIALS);
+        assert(deck_corpus == nullptr || num_trials <= deck_corpus->size());
+        const uint64_t MIN_CHUNK_SIZE = 16;
+        const uint64_t MAX_NUM_CHUNKS = 1024;
+        const uint64_t num_chunks = std::min(MAX_NUM_CHUNKS, (num_trials + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE);
+        if (!do_parallel)
+        {
+            scheduler_options = SchedulerOptions{1, false};
+        }
+        std::vector<std::vector<GamesStats>> threads_stats(get_num_threads(scheduler_options),
+                                                           std::vector<GamesStats>(strategies.size()));
+        auto play_chunk = [&](uint64_t chunk_index, unsigned thread_index)
+        {
+            auto &strategies_stats = threads_stats[thread_index];
+            const uint64_t first_seed = num_trials * chunk_index / num_chunks;
+            const uint64_t last_seed = num_trials * (chunk_index + 1) / num_chunks;
+            for (uint64_t seed = first_seed; seed < last_seed; ++seed)
+            {
+                const ShuffledDeck deck = get_deck(seed, deck_rng, deck_corpus);
+                for (size_t i = 0; i < strategies.size(); ++i)
+                {
+                    strategies_stats[i].add(play_game(deck, num_players, card_reach_distance_normal,
+                                                      card_reach_distance_endgame, TurnEngine::Greedy, nullptr,
+                                                      strategies[i]));
+                }
+            }
+        };
+        parallel_for_chunks(num_chunks, scheduler_options, play_chunk);
+        std::vector<StrategyCell> cells;
+        for (size_t i = 0; i < strategies.size(); ++i)
+        {
+            GamesStats games_stats;
+            for (const auto &strategies_stats : threads_stats)
+            {
+                games_stats.merge(strategies_stats[i]);
+            }
+            cells.push_back({strategies[i], calculate_games_stats(games_stats)});
+        }
+        return cells;
+    }
+
+    std::string to_json(const std::vector<StrategyCell> &cells)
+    {
+        std::ostringstream oss;
+        for (const auto &cell : cells)
+        {
+            oss << "{ \"strategy\": \"" << to_string(cell.strategy) << "\""
+                << ", \"results\": " << to_string(cell.results) << "}\n";
+        }
+        return oss.str();
+    }
+
+} // namespace TheGameAnalyzer
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "game.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace TheGameAnalyzer
+{
+    // Inclusive range of a swept parameter.
+    struct SweepRange
+    {
+        int first{0};
+        int last{0};
+    };
+
+    // Results for one (num_players, reach distance, endgame reach distance) configuration.
+    struct SweepCell
+    {
+        int num_players{0};
+        int card_reach_distance_normal{0};
+        int card_reach_distance_endgame{0};
+        TheGamesResults results;
+    };
+
+    // Play every configuration in a grid over the same decks.
+    //
+    // Like the README tables, only configurations with the endgame reach
+    // distance at least the normal one are played. Each deck is shuffled
+    // once, and for each number of players it's played by every
+    // configuration at once with play_game_forked().
+    //
+    // \param num_players Range of number of players (1-5).
+    // \param card_reach_distance_normal Range of reach distances before the endgame.
+    // \param card_reach_distance_endgame Range of reach distances during the endgame.
+    // \param num_trials Number of decks, seeds [0, num_trials).
+    // \param do_parallel If true play the decks in parallel.
+    // \param turn_engine How each turn is chosen.
+    // \param deck_rng How the decks are shuffled.
+    // \param deck_corpus If not null, play decks [0, num_trials) of the corpus instead of shuffling.
+    // \param scheduler_options Threads to play on if do_parallel.
+    // \return Results for each configuration, by num_players, then normal, then endgame reach distance.
+    std::vector<SweepCell> play_sweep(SweepRange num_players, SweepRange card_reach_distance_normal,
+                                      SweepRange card_reach_distance_endgame, uint64_t num_trials,
+                                      bool do_parallel, TurnEngine turn_engine = TurnEngine::Greedy,
+                                      DeckRng deck_rng = DeckRng::StdCompat,
+                                      const DeckCorpus *deck_corpus = nullptr,
+                                      SchedulerOptions scheduler_options = {});
+
+    // One JSON object per line for each cell.
+    std::string to_json(const std::vector<SweepCell> &cells);
+
+    // The README tables: excellent and beat the game percentages for each number of players.
+    std::string to_markdown(const std::vector<SweepCell> &cells);
+
+    // Trials every configuration plays in the first round of play_race().
+    const uint64_t RACE_FIRST_ROUND_TRIALS = 100;
+
+    enum class RaceCellStatus
+    {
+        Winner,    // Fewest cards left on average at the end.
+        Contender, // Not yet separated from the winner when the trials ran out.
+        Dominated, // Dropped: more cards left than the leader, with the confidence asked for.
+        Tied,      // Dropped: the same result as the leader on every trial so far.
+    };
+
+    // A configuration of play_race().
+    struct RaceCell
+    {
+        int card_reach_distance_normal{0};
+        int card_reach_distance_endgame{0};
+        RaceCellStatus status{RaceCellStatus::Contender};
+        uint64_t num_trials{0}; // Trials played before being dropped or the race ended.
+        double cards_left_average{0.0};
+        // Paired difference in cards left from the leader over num_trials (the
+        // winner if not dropped), and the half width of its confidence interval
+        // at the comparison confidence.
+        double cards_left_diff{0.0};
+        double cards_left_diff_half_width{0.0};
+    };
+
+    struct RaceResult
+    {
+        int num_players{0};
+        double confidence{0.0};
+        double comparison_confidence{0.0}; // Level of each comparison, confidence with the correction.
+        uint64_t num_games{0};           // Games played, all configurations.
+        uint64_t num_games_full_grid{0}; // Games a sweep with the same trials would play.
+        std::vector<RaceCell> cells;     // By status, then by difference from the leader.
+    };
+
+    // Find the reach distances that leave the fewest cards, only playing
+    // trials while they can still change the answer.
+    //
+    // Configurations are as play_sweep(). They all play the same seeds, in
+    // rounds of RACE_FIRST_ROUND_TRIALS and then doubling. After each round
+    // the leader is the configuration with the fewest cards left on average,
+    // and a configuration is dropped if the confidence interval of its
+    // paired difference from the leader is all above 0. Each comparison is
+    // at a Bonferroni corrected level, for every other configuration in
+    // every round the race can play, so the best configuration is dropped
+    // with probability at most 1 - confidence over the whole race. The
+    // race ends when one configuration is left or after
+    // max_trials seeds. If the ranges have no configuration, no games are
+    // played and there are no cells.
+    //
+    // \param num_players Number of players (1-5).
+    // \param card_reach_distance_normal Range of reach distances before the endgame.
+    // \param card_reach_distance_endgame Range of reach distances during the endgame.
+    // \param max_trials Most seeds to play, [0, max_trials).
+    // \param confidence Confidence level of the whole race, e.g. 0.95.
+    // \param do_parallel If true play each round's seeds in parallel.
+    // \param turn_engine How each turn is chosen.
+    // \param deck_rng How the decks are shuffled.
+    // \param deck_corpus If not null, play decks of the corpus instead of shuffling.
+    // \param scheduler_options Threads to play on if do_parallel.
+    RaceResult play_race(int num_players, SweepRange card_reach_distance_normal,
+                         SweepRange card_reach_distance_endgame, uint64_t max_trials, double confidence,
+                         bool do_parallel, TurnEngine turn_engine = TurnEngine::Greedy,
+                         DeckRng deck_rng = DeckRng::StdCompat, const DeckCorpus *deck_corpus = nullptr,
+                         SchedulerOptions scheduler_options = {});
+
+    std::string to_string(RaceCellStatus status);
+
+    // JSON, one configuration per line.
+    std::string to_string(const RaceResult &race_result);
+
+    // Results of one strategy of play_strategies().
+    struct StrategyCell
+    {
+        Strategy strategy{Strategy::Basic};
+        TheGamesResults results;
+    };
+
+    // Play several strategies over the same decks.
+    //
+    // Each deck is shuffled once and played by every strategy in turn, with
+    // the greedy turn engine. Same results as play_games() for each strategy.
+    //
+    // \param num_players Number of players (1-5).
+    // \param card_reach_distance_normal How much to reach for playing another card (before the endgame).
+    // \param card_reach_distance_endgame How much to reach for playing another card during the endgame.
+    // \param strategies Strategies to play.
+    // \param num_trials Number of decks, seeds [0, num_trials).
+    // \param do_parallel If true play the decks in parallel.
+    // \param deck_rng How the decks are shuffled.
+    // \param deck_corpus If not null, play decks [0, num_trials) of the corpus instead of shuffling.
+    // \param scheduler_options Threads to play on if do_parallel.
+    // \return Results for each strategy, in the order given.
+    std::vector<StrategyCell> play_strategies(int num_players, int card_reach_distance_normal,
+                                              int card_reach_distance_endgame,
+                                              const std::vector<Strategy> &strategies, uint64_t num_trials,
+                                              bool do_parallel, DeckRng deck_rng = DeckRng::StdCompat,
+                                              const DeckCorpus *deck_corpus = nullptr,
+                                              SchedulerOptions scheduler_options = {});
+
+    // One JSON object per line for each strategy.
+    std::string to_json(const std::vector<StrategyCell> &cells);
+
+} // namespace TheGameAnalyzer
@@ -1,20 +1,25 @@
 #include "turn.hpp"
 
+#include "card_set.hpp"
+#include "metrics.hpp"
+#include "strategy.hpp"
+
 #include <algorithm>
 #include <array>
 #include <cassert>
 #include <cmath>
+#include <optional>
 #include <sstream>
-#include <vector>
 
 namespace TheGameAnalyzer
 {
-    std::string to_string(const Hand &hand)
+    template <typename Cards>
+    static std::string cards_to_string(const Cards &cards)
     {
         std::ostringstream oss;
         oss << "{";
         bool first = true;
-        for (const auto c : hand)
+        for (const auto c : cards)
         {
             if (first)
             {
@@ -30,6 +35,26 @@ namespace TheGameAnalyzer
         return oss.str();
     }
 
+    std::string to_string(const Hand &hand)
+    {
+        return cards_to_string(hand);
+    }
+
+    std::string to_string(const Deck &deck)
+    {
+        return cards_to_string(deck);
+    }
+
+    std::string to_string(CardSet card_set)
+    {
+        Deck cards;
+        for (; !card_set.empty(); card_set.erase(card_set.lowest()))
+        {
+            cards.push_back(card_set.lowest());
+        }
+        return cards_to_string(cards);
+    }
+
     void flip_hand(Hand &hand)
     {
         std::reverse(hand.begin(), hand.end());
@@ -37,16 +62,24 @@ namespace TheGameAnalyzer
                        { flip_card(c); return c; });
     }
 
-    void flip_hand_mask(HandMask &hand_mask, size_t hand_size)
+    // Bits of each byte in reverse order.
+    static constexpr std::array<uint8_t, 256> make_reversed_bytes()
     {
-        HandMask new_hand_mask = 0;
-        // TODO this could be faster with a lookup table.
-        for (size_t i = hand_size; i-- > 0;)
+        std::array<uint8_t, 256> table{};
+        for (unsigned b = 0; b < 256; ++b)
         {
-            new_hand_mask |= ((hand_mask & 1) << i);
-            hand_mask >>= 1;
+            for (unsigned i = 0; i < 8; ++i)
+            {
+                table[b] |= ((b >> i) & 1) << (7 - i);
+            }
         }
-        hand_mask = new_hand_mask;
+        return table;
+    }
+
+    void flip_hand_mask(HandMask &hand_mask, size_t hand_size)
+    {
+        static constexpr auto reversed_bytes = make_reversed_bytes();
+        hand_mask = reversed_bytes[hand_mask & 0xff] >> (MAX_HAND_SIZE - hand_size);
     }
 
     int get_num_cards_in_hand_mask(HandMask hand_mask)
@@ -169,40 +202,32 @@ namespace TheGameAnalyzer
         return oss.str();
     }
 
-    TenGroups get_ten_groups(const Hand &hand)
+    static TenGroups get_ten_groups(CardSet cards)
     {
         TenGroups ten_groups;
-        for (size_t i = 0; i < hand.size(); ++i)
+        // A group starts with a card that has a card 10 above it but not 10 below it.
+        auto group_starts = cards & cards.shifted_down(10) & ~cards.shifted_up(10);
+        for (; !group_starts.empty(); group_starts.erase(group_starts.lowest()))
         {
-            const HandMask card_mask = 1 << i;
-            if ((card_mask & ten_groups.groups_hand_mask) != 0)
+            Card c = group_starts.lowest();
+            const size_t lo = cards.rank(c);
+            TenGroup tg{lo, lo, static_cast<HandMask>(1 << lo)};
+            for (c += 10; cards.contains(c); c += 10)
             {
-                continue;
-            }
-            Card num_to_find = hand[i] + 10;
-            TenGroup tg{i, i, card_mask};
-            for (size_t j = i + 1; j < hand.size(); ++j)
-            {
-                if (hand[j] > num_to_find)
-                {
-                    break;
-                }
-                if (hand[j] == num_to_find)
-                {
-                    num_to_find += 10;
-                    tg.hand_mask |= 1 << j;
-                    tg.hi = j;
-                }
-            }
-            if (tg.lo != tg.hi)
-            {
-                ten_groups.groups_hand_mask |= tg.hand_mask;
-                ten_groups.push_back(tg);
+                tg.hi = cards.rank(c);
+                tg.hand_mask |= 1 << tg.hi;
             }
+            ten_groups.groups_hand_mask |= tg.hand_mask;
+            ten_groups.push_back(tg);
         }
         return ten_groups;
     }
 
+    TenGroups get_ten_groups(const Hand &hand)
+    {
+        return get_ten_groups(CardSet(hand));
+    }
+
     std::string to_string(const Piles &piles)
     {
         std::ostringstream oss;
@@ -224,20 +249,107 @@ namespace TheGameAnalyzer
         return oss.str();
     }
 
-    Plays get_plays_ascending(Card pile_card, Card max_card, size_t piles_index, const Hand &hand,
-                              const TenGroups &ten_groups, int min_cards_for_turn,
-                              int card_reach_distance)
+    // The hand as seen from an ascending pile.
+    struct AscendingHandView
+    {
+        const Hand &hand;
+        CardSet cards;
+
+        size_t size() const { return hand.size(); }
+        Card operator[](size_t i) const { return hand[i]; }
+        HandMask mask(size_t i) const { return static_cast<HandMask>(1 << i); }
+        Card orient(Card c) const { return c; }
+        bool contains(Card c) const { return cards.contains(c); }
+        size_t rank(Card c) const { return cards.rank(c); }
+        size_t num_above(Card c) const { return static_cast<size_t>(cards.above(c).size()); }
+    };
+
+    // The hand as seen from a descending pile: flipped cards in reverse order,
+    // without copying the hand. Masks are for the real hand.
+    struct DescendingHandView
+    {
+        const Hand &hand;
+        CardSet cards;
+
+        size_t size() const { return hand.size(); }
+        Card operator[](size_t i) const { return orient(hand[hand.size() - 1 - i]); }
+        HandMask mask(size_t i) const { return static_cast<HandMask>(1 << (hand.size() - 1 - i)); }
+        Card orient(Card c) const
+        {
+            flip_card(c);
+            return c;
+        }
+        bool contains(Card c) const { return cards.contains(orient(c)); }
+        size_t rank(Card c) const { return hand.size() - 1 - cards.rank(orient(c)); }
+        size_t num_above(Card c) const { return static_cast<size_t>(cards.below(orient(c)).size()); }
+    };
+
+    // Ten groups of a hand as seen through DescendingHandView.
+    static TenGroups get_descending_ten_groups(const TenGroups &ten_groups, size_t hand_size)
+    {
+        TenGroups descending_ten_groups;
+        descending_ten_groups.groups_hand_mask = ten_groups.groups_hand_mask;
+        // Same order as get_ten_groups() on the flipped hand: the highest group top first.
+        auto &groups = descending_ten_groups.groups;
+        for (size_t g = 0; g < ten_groups.groups.size(); ++g)
+        {
+            TenGroup tg{hand_size - 1 - ten_groups[g].hi, hand_size - 1 - ten_groups[g].lo, ten_groups[g].hand_mask};
+            descending_ten_groups.push_back(tg);
+            for (size_t j = groups.size() - 1; j > 0 && groups[j - 1].lo > groups[j].lo; --j)
+            {
+                std::swap(groups[j - 1], groups[j]);
+            }
+        }
+        return descending_ten_groups;
+    }
+
+    // get_plays_ascending() for either view of the hand and any strategy. The
+    // ten groups' lo and hi are view indexes, their masks are for the real hand.
+    //
+    // \param played_cards Cards played so far, if the strategy remembers them.
+    template <typename StrategyPolicy, typename HandView>
+    static Plays get_plays(Card pile_card, Card max_card, size_t piles_index, const HandView &hand,
+                           const TenGroups &ten_groups, CardSet played_cards, int min_cards_for_turn,
+                           int card_reach_distance)
     {
+        // Distance from last_card up to card. Remembering strategies don't
+        // count the played cards in between: jumping over them loses nothing.
+        auto get_delta = [&](Card last_card, Card card)
+        {
+            int delta = card - last_card;
+            if constexpr (StrategyPolicy::remember_played_cards)
+            {
+                if (delta > 1)
+                {
+                    const Card c1 = hand.orient(last_card);
+                    const Card c2 = hand.orient(card);
+                    delta -= played_cards.between(std::min(c1, c2), std::max(c1, c2)).size();
+                }
+            }
+            return delta;
+        };
+
+        // For each hand index, bit mask of the ten_groups whose span covers it.
+        std::array<uint8_t, MAX_HAND_SIZE> covering_groups{};
+        for (size_t g = 0; g < ten_groups.groups.size(); ++g)
+        {
+            for (size_t j = ten_groups[g].lo; j <= ten_groups[g].hi; ++j)
+            {
+                covering_groups[j] |= 1 << g;
+            }
+        }
+
         Plays plays;
         HandMask hand_mask = 0;
         Card last_card = pile_card;
         const Card pile_card_minus_10 = pile_card - 10;
-        size_t i = static_cast<size_t>(std::find(hand.begin(), hand.end(), pile_card_minus_10) - hand.begin());
-        if (i < hand.size())
+        size_t i;
+        if (pile_card_minus_10 > 0 && hand.contains(pile_card_minus_10))
         {
+            i = hand.rank(pile_card_minus_10);
             Play play;
             play.piles_index = piles_index;
-            play.pile_card_start = last_card;
+            play.pile_card_start = hand.orient(last_card);
             auto group_it = std::find_if(ten_groups.begin(), ten_groups.end(), [=](const auto &g)
                                          { return i == g.hi; });
             if (group_it != ten_groups.end())
@@ -247,19 +359,18 @@ namespace TheGameAnalyzer
             }
             else
             {
-                play.hand_mask = 1 << i; // card mask
+                play.hand_mask = hand.mask(i);
             }
-            play.pile_card_end = hand[i];
-            play.delta = play.pile_card_end - play.pile_card_start;
+            play.pile_card_end = hand.orient(hand[i]);
+            play.delta = get_delta(last_card, hand[i]);
             hand_mask |= play.hand_mask;
             plays.push_back(std::move(play));
             last_card = hand[i];
         }
         else
         {
-            i = static_cast<size_t>(std::find_if(hand.begin(), hand.end(), [=](const Card c)
-                                                 { return c > pile_card; }) -
-                                    hand.begin());
+            // Index of the next card above the pile.
+            i = hand.size() - hand.num_above(pile_card);
         }
 
         for (; i < hand.size(); ++i)
@@ -268,7 +379,7 @@ namespace TheGameAnalyzer
             {
                 break;
             }
-            const HandMask card_mask = 1 << i;
+            const HandMask card_mask = hand.mask(i);
 
             // Skip cards that are already in a play.
             if ((card_mask & hand_mask) != 0)
@@ -276,18 +387,27 @@ namespace TheGameAnalyzer
                 continue;
             }
 
-            auto group_it = std::find_if(ten_groups.begin(), ten_groups.end(), [=](const auto &g)
-                                         { return (g.lo <= i && i <= g.hi) && (hand_mask & g.hand_mask) == 0; });
+            // First covering group that hasn't been played yet.
+            const TenGroup *group = nullptr;
+            for (unsigned groups = covering_groups[i]; groups != 0; groups &= groups - 1)
+            {
+                const auto &g = ten_groups[static_cast<size_t>(__builtin_ctz(groups))];
+                if ((hand_mask & g.hand_mask) == 0)
+                {
+                    group = &g;
+                    break;
+                }
+            }
             if (get_num_cards_in_hand_mask(hand_mask) >= min_cards_for_turn)
             {
                 // Bail if we have enough cards and not enough small enough jump to play an extra.
-                const int card_delta = hand[i] - last_card;
+                const int card_delta = get_delta(last_card, hand[i]);
                 if (card_delta > card_reach_distance)
                 {
                     break;
                 }
                 // If the card is within the delta but the start of a group then skip it.
-                if (group_it != ten_groups.end() && group_it->lo == i)
+                if (StrategyPolicy::skip_near_group_card && group != nullptr && group->lo == i)
                 {
                     break;
                 }
@@ -295,27 +415,27 @@ namespace TheGameAnalyzer
 
             Play play;
             play.piles_index = piles_index;
-            play.pile_card_start = last_card;
-            if (group_it != ten_groups.end())
+            play.pile_card_start = hand.orient(last_card);
+            if (group != nullptr)
             {
                 // Add in all proceeding unmasked cards in this group to the group.
-                for (size_t j = i; j < group_it->hi; ++j)
+                for (size_t j = i; j < group->hi; ++j)
                 {
-                    const unsigned next_card_mask = 1 << j;
+                    const HandMask next_card_mask = hand.mask(j);
                     if ((next_card_mask & (hand_mask | ten_groups.groups_hand_mask)) == 0)
                     {
                         play.hand_mask |= next_card_mask;
                     }
                 }
-                play.hand_mask |= group_it->hand_mask;
-                i = group_it->lo;
+                play.hand_mask |= group->hand_mask;
+                i = group->lo;
             }
             else
             {
                 play.hand_mask = card_mask;
             }
-            play.pile_card_end = hand[i];
-            play.delta = play.pile_card_end - play.pile_card_start;
+            play.pile_card_end = hand.orient(hand[i]);
+            play.delta = get_delta(last_card, hand[i]);
             hand_mask |= play.hand_mask;
             plays.push_back(std::move(play));
             last_card = hand[i];
@@ -323,6 +443,15 @@ namespace TheGameAnalyzer
         return plays;
     }
 
+    Plays get_plays_ascending(Card pile_card, Card max_card, size_t piles_index, const Hand &hand,
+                              const TenGroups &ten_groups, int min_cards_for_turn,
+                              int card_reach_distance)
+    {
+        const AscendingHandView hand_view{hand, CardSet(hand)};
+        return get_plays<BasicStrategy>(pile_card, max_card, piles_index, hand_view, ten_groups, CardSet(),
+                                        min_cards_for_turn, card_reach_distance);
+    }
+
     std::string to_string(PilesIndexes piles_indexes)
     {
         std::ostringstream oss;
@@ -369,57 +498,50 @@ namespace TheGameAnalyzer
         return oss.str();
     }
 
-    static int get_sum_of_pile_extremes(const Piles &piles)
-    {
-        return std::min(piles[0], piles[1]) - std::max(piles[2], piles[3]);
-    }
-
     using PilesOfPlays = std::array<Plays, 4>;
 
-    PilesOfPlays get_piles_of_plays(const Piles &piles, const Hand &hand, int min_cards_for_turn, int card_reach_distance)
+    template <typename StrategyPolicy>
+    static PilesOfPlays get_piles_of_plays(const Piles &piles, const Hand &hand, const CardSet &played_cards,
+                                           int min_cards_for_turn, int card_reach_distance)
     {
+        TGA_METRICS_TIMER(Metric::PilesOfPlays);
         PilesOfPlays piles_of_plays;
+        // Don't play past the other pile in the same direction.
         Piles bound_cards = {100, 100, 1, 1};
-        // ascending piles
+        if (piles[0] <= piles[1])
         {
-            if (piles[0] <= piles[1])
-            {
-                bound_cards[0] = piles[1];
-            }
-            else
-            {
-                bound_cards[1] = piles[0];
-            }
-            const auto ten_groups = get_ten_groups(hand);
-
-            for (size_t i = 0; i < 2; ++i)
-            {
-                piles_of_plays[i] = get_plays_ascending(piles[i], bound_cards[i], i, hand, ten_groups, min_cards_for_turn, card_reach_distance);
-            }
+            bound_cards[0] = piles[1];
         }
-
-        // descending piles
+        else
         {
-            auto flipped_hand = hand;
-            flip_hand(flipped_hand);
-            if (piles[2] <= piles[3])
-            {
-                bound_cards[3] = piles[2];
-            }
-            else
-            {
-                bound_cards[2] = piles[3];
-            }
-            const auto ten_groups = get_ten_groups(flipped_hand);
+            bound_cards[1] = piles[0];
+        }
+        if (piles[2] <= piles[3])
+        {
+            bound_cards[3] = piles[2];
+        }
+        else
+        {
+            bound_cards[2] = piles[3];
+        }
 
-            for (size_t i = 2; i < 4; ++i)
-            {
-                flip_card(bound_cards[i]);
-                auto pile_card = piles[i];
-                flip_card(pile_card);
-                piles_of_plays[i] = get_plays_ascending(pile_card, bound_cards[i], i, flipped_hand, ten_groups, min_cards_for_turn, card_reach_distance);
-                flip_plays(piles_of_plays[i], hand.size());
-            }
+        const CardSet cards(hand);
+        const auto ten_groups = get_ten_groups(cards);
+        const auto descending_ten_groups = get_descending_ten_groups(ten_groups, hand.size());
+        const AscendingHandView ascending_hand{hand, cards};
+        const DescendingHandView descending_hand{hand, cards};
+        const CardSet remembered_cards = StrategyPolicy::remember_played_cards ? played_cards : CardSet();
+        for (size_t i = 0; i < 2; ++i)
+        {
+            piles_of_plays[i] = get_plays<StrategyPolicy>(piles[i], bound_cards[i], i, ascending_hand, ten_groups,
+                                                          remembered_cards, min_cards_for_turn, card_reach_distance);
+        }
+        for (size_t i = 2; i < 4; ++i)
+        {
+            piles_of_plays[i] = get_plays<StrategyPolicy>(descending_hand.orient(piles[i]),
+                                                          descending_hand.orient(bound_cards[i]), i, descending_hand,
+                                                          descending_ten_groups, remembered_cards, min_cards_for_turn,
+                                                          card_reach_distance);
         }
         return piles_of_plays;
     }
@@ -474,46 +596,12 @@ namespace TheGameAnalyzer
 
     bool TurnCompare::operator()(const Turn &t1, const Turn &t2) const
     {
-        const int t1_num_cards = get_num_cards_in_hand_mask(t1.hand_mask);
-        const int t2_num_cards = get_num_cards_in_hand_mask(t2.hand_mask);
-        const bool t1_has_min_cards = t1_num_cards >= min_cards_for_turn;
-        const bool t2_has_min_cards = t2_num_cards >= min_cards_for_turn;
-        if (t1_has_min_cards != t2_has_min_cards)
-        {
-            // 1. Prefer minimum number of cards played.
-            return t2_has_min_cards;
-        }
-        if (t1.delta != t2.delta)
-        {
-            // 2. Prefer smaller delta.
-            return t2.delta < t1.delta;
-        }
-        else if (t1.reached_for_group != t2.reached_for_group)
-        {
-            // 3. Prefer the plays that didn't reach for a group.
-            return t1.reached_for_group;
-        }
-        else if (t1_num_cards != t2_num_cards)
-        {
-            // 4. Prefer the turn that used more cards.
-            return t2_num_cards > t1_num_cards;
-        }
-        else
-        {
-            // 5. Prefer to keep the numbers on the extreme intact.
-            const int sum_of_pile_extremes1 = get_sum_of_pile_extremes(t1.piles);
-            const int sum_of_pile_extremes2 = get_sum_of_pile_extremes(t2.piles);
-            if (sum_of_pile_extremes2 < sum_of_pile_extremes1)
-            {
-                return true;
-            }
-        }
-
-        return false;
+        return StrategyTurnCompare<BasicStrategy>{min_cards_for_turn}(t1, t2);
     }
 
     Turn get_best_min_cards_all_piles(const Piles &piles, const PilesOfPlays &piles_of_plays, int min_cards_for_turn)
     {
+        TGA_METRICS_TIMER(Metric::BestMinCards);
         Turn t;
         t.piles = piles;
         std::optional<size_t> pi;
@@ -546,6 +634,7 @@ namespace TheGameAnalyzer
 
     void play_reach_cards(const PilesOfPlays &piles_of_plays, int card_reach_distance, Turn &t)
     {
+        TGA_METRICS_TIMER(Metric::ReachCards);
         std::optional<size_t> pi;
         while ((pi = get_next_min_play_piles_index(piles_of_plays, t.piles_indexes, t.hand_mask)).has_value())
         {
@@ -560,12 +649,20 @@ namespace TheGameAnalyzer
 
     Turn find_best_turn(const Piles &piles, const Hand &hand, int min_cards_for_turn, int card_reach_distance)
     {
-        PilesOfPlays piles_of_plays = get_piles_of_plays(piles, hand, min_cards_for_turn, card_reach_distance);
+        return find_best_turn<BasicStrategy>(piles, hand, CardSet(), min_cards_for_turn, card_reach_distance);
+    }
+
+    template <typename StrategyPolicy>
+    Turn find_best_turn(const Piles &piles, const Hand &hand, const CardSet &played_cards,
+                        int min_cards_for_turn, int card_reach_distance)
+    {
+        const PilesOfPlays piles_of_plays = get_piles_of_plays<StrategyPolicy>(
+            piles, hand, played_cards, min_cards_for_turn, card_reach_distance);
         Turn best_turn = get_best_min_cards_all_piles(piles, piles_of_plays, min_cards_for_turn);
         for (size_t pi = 0; pi < piles.size(); ++pi)
         {
             auto pile_turn = get_best_min_cards_in_pile(piles, piles_of_plays[pi], pi, min_cards_for_turn);
-            const TurnCompare turn_compare{min_cards_for_turn};
+            const StrategyTurnCompare<StrategyPolicy> turn_compare{min_cards_for_turn};
             if (turn_compare(best_turn, pile_turn))
             {
                 best_turn = pile_turn;
@@ -574,4 +671,52 @@ namespace TheGameAnalyzer
         play_reach_cards(piles_of_plays, card_reach_distance, best_turn);
         return best_turn;
     }
+
+    // Every strategy of visit_strategy().
+    template Turn find_best_turn<BasicStrategy>(const Piles &, const Hand &, const CardSet &, int, int);
+    template Turn find_best_turn<NoDeltaTiebreakStrategy>(const Piles &, const Hand &, const CardSet &, int, int);
+    template Turn find_best_turn<NoGroupReachTiebreakStrategy>(const Piles &, const Hand &, const CardSet &, int, int);
+    template Turn find_best_turn<NoMoreCardsTiebreakStrategy>(const Piles &, const Hand &, const CardSet &, int, int);
+    template Turn find_best_turn<NoPileExtremesTiebreakStrategy>(const Piles &, const Hand &, const CardSet &, int, int);
+    template Turn find_best_turn<ReachNearGroupCardStrategy>(const Piles &, const Hand &, const CardSet &, int, int);
+    template Turn find_best_turn<FirstHandStartsStrategy>(const Piles &, const Hand &, const CardSet &, int, int);
+    template Turn find_best_turn<CardMemoryStrategy>(const Piles &, const Hand &, const CardSet &, int, int);
+
+    std::string to_string(Strategy strategy)
+    {
+        switch (strategy)
+        {
+        case Strategy::Basic:
+            return "basic";
+        case Strategy::NoDeltaTiebreak:
+            return "no-delta-tiebreak";
+        case Strategy::NoGroupReachTiebreak:
+            return "no-group-reach-tiebreak";
+        case Strategy::NoMoreCardsTiebreak:
+            return "no-more-cards-tiebreak";
+        case Strategy::NoPileExtremesTiebreak:
+            return "no-pile-extremes-tiebreak";
+        case Strategy::ReachNearGroupCard:
+            return "reach-near-group-card";
+        case Strategy::FirstHandStarts:
+            return "first-hand-starts";
+        case Strategy::CardMemory:
+            return "card-memory";
+        }
+        assert(false);
+        return "";
+    }
+
+    std::optional<Strategy> parse_strategy(const std::string &name)
+    {
+        for (size_t i = 0; i < NUM_STRATEGIES; ++i)
+        {
+            const auto strategy = static_cast<Strategy>(i);
+            if (name == to_string(strategy))
+            {
+                return strategy;
+            }
+        }
+        return std::nullopt;
+    }
 } // namespace TheGameAnalyzer
\ No newline at end of file
@@ -1,18 +1,30 @@
 #pragma once
 
+#include "fixed_vector.hpp"
+
 #include <array>
+#include <cstdint>
 #include <string>
-#include <vector>
 
 namespace TheGameAnalyzer
 {
     using Card = int16_t;
     inline void flip_card(Card &c) { c = 101 - c; }
 
-    using Hand = std::vector<Card>;
+    // Max number of cards in a hand (1 player game).
+    const size_t MAX_HAND_SIZE = 8;
+
+    using Hand = FixedVector<Card, MAX_HAND_SIZE>;
 
     std::string to_string(const Hand &hand);
 
+    // Number of cards in the deck, [2 - 99].
+    const size_t NUM_CARDS_IN_DECK = 98;
+
+    using Deck = FixedVector<Card, NUM_CARDS_IN_DECK>;
+
+    std::string to_string(const Deck &deck);
+
     // Flip the cards and reverse the order.
     void flip_hand(Hand &hand);
 
@@ -42,7 +54,8 @@ namespace TheGameAnalyzer
     // Flip the play.
     void flip_play(Play &, size_t hand_size);
 
-    using Plays = std::vector<Play>;
+    // Every play uses at least one card.
+    using Plays = FixedVector<Play, MAX_HAND_SIZE>;
     std::string to_string(const Plays &);
 
     // Flip the plays
@@ -63,12 +76,12 @@ namespace TheGameAnalyzer
     // Container for 10s groupings.
     struct TenGroups
     {
-        std::vector<TenGroup> groups;
+        FixedVector<TenGroup, MAX_HAND_SIZE / 2> groups;
         HandMask groups_hand_mask{0};
         const TenGroup &operator[](size_t idx) const { return groups[idx]; };
         void push_back(TenGroup &tg) { groups.push_back(tg); };
-        std::vector<TenGroup>::const_iterator begin() const { return groups.begin(); };
-        std::vector<TenGroup>::const_iterator end() const { return groups.end(); };
+        const TenGroup *begin() const { return groups.begin(); };
+        const TenGroup *end() const { return groups.end(); };
     };
     bool operator==(const TenGroups &tg1, const TenGroups &tg2);
     bool operator!=(const TenGroups &tg1, const TenGroups &tg2);
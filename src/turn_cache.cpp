@@ -0,0 +1,138 @@
+#include "turn_cache.hpp"
+
+#include <cassert>
+
+namespace TheGameAnalyzer
+{
+    bool operator==(const TurnCacheKey &k1, const TurnCacheKey &k2)
+    {
+        return k1.lo == k2.lo && k1.hi == k2.hi;
+    }
+
+    // Layout (cards are < 128 so fit in 7 bits, empty hand slots are 0):
+    //   lo: hand cards [0 - 7] (56 bits), min_cards_for_turn (2 bits), engine (6 bits)
+    //   hi: piles (28 bits), card_reach_distance (8 bits)
+    TurnCacheKey make_turn_cache_key(const Piles &piles, const Hand &hand, int min_cards_for_turn,
+                                     int card_reach_distance, unsigned engine)
+    {
+        TurnCacheKey key;
+        for (size_t i = 0; i < hand.size(); ++i)
+        {
+            key.lo |= static_cast<uint64_t>(hand[i]) << (7 * i);
+        }
+        key.lo |= static_cast<uint64_t>(min_cards_for_turn & 0x3) << 56;
+        key.lo |= static_cast<uint64_t>(engine & 0x3f) << 58;
+        for (size_t i = 0; i < piles.size(); ++i)
+        {
+            key.hi |= static_cast<uint64_t>(piles[i]) << (7 * i);
+        }
+        key.hi |= static_cast<uint64_t>(card_reach_distance & 0xff) << 28;
+        return key;
+    }
+
+    // Layout: piles (28 bits), hand_mask (8 bits), delta + 512 (10 bits),
+    // piles_indexes (16 bits), reached_for_group (1 bit), valid (1 bit).
+    static uint64_t pack_turn(const Turn &turn)
+    {
+        assert(turn.delta > -512 && turn.delta < 512);
+        uint64_t packed = 0;
+        for (size_t i = 0; i < turn.piles.size(); ++i)
+        {
+            packed |= static_cast<uint64_t>(turn.piles[i]) << (7 * i);
+            packed |= static_cast<uint64_t>(turn.piles_indexes[i]) << (46 + 4 * i);
+        }
+        packed |= static_cast<uint64_t>(turn.hand_mask) << 28;
+        packed |= static_cast<uint64_t>(turn.delta + 512) << 36;
+        packed |= static_cast<uint64_t>(turn.reached_for_group) << 62;
+        packed |= uint64_t{1} << 63;
+        return packed;
+    }
+
+    static Turn unpack_turn(uint64_t packed)
+    {
+        Turn turn;
+        for (size_t i = 0; i < turn.piles.size(); ++i)
+        {
+            turn.piles[i] = static_cast<Card>((packed >> (7 * i)) & 0x7f);
+            turn.piles_indexes[i] = (packed >> (46 + 4 * i)) & 0xf;
+        }
+        turn.hand_mask = static_cast<HandMask>((packed >> 28) & 0xff);
+        turn.delta = static_cast<int>((packed >> 36) & 0x3ff) - 512;
+        turn.reached_for_group = ((packed >> 62) & 1) != 0;
+        return turn;
+    }
+
+    TurnCache::TurnCache(size_t max_bytes)
+    {
+        size_t num_slots = 1;
+        while (num_slots * 2 * sizeof(Slot) <= max_bytes)
+        {
+            num_slots *= 2;
+        }
+        slots_ = std::make_unique<Slot[]>(num_slots);
+        slots_mask_ = num_slots - 1;
+    }
+
+    TurnCache::Slot &TurnCache::get_slot(const TurnCacheKey &key) const
+    {
+        // splitmix64 finalizer.
+        uint64_t h = key.lo ^ (key.hi * 0x9e3779b97f4a7c15);
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111eb;
+        h ^= h >> 31;
+        return slots_[h & slots_mask_];
+    }
+
+    std::optional<Turn> TurnCache::find(const TurnCacheKey &key) const
+    {
+        const Slot &slot = get_slot(key);
+        const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if ((sequence & 1) != 0)
+        {
+            return std::nullopt;
+        }
+        const uint64_t key_lo = slot.key_lo.load(std::memory_order_relaxed);
+        const uint64_t key_hi = slot.key_hi.load(std::memory_order_relaxed);
+        const uint64_t packed_turn = slot.turn.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence ||
+            packed_turn == 0 || key_lo != key.lo || key_hi != key.hi)
+        {
+            return std::nullopt;
+        }
+        return unpack_turn(packed_turn);
+    }
+
+    void TurnCache::insert(const TurnCacheKey &key, const Turn &turn)
+    {
+        Slot &slot = get_slot(key);
+        uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        if ((sequence & 1) != 0 ||
+            !slot.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_relaxed))
+        {
+            // Another thread is writing this slot.
+            return;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.key_lo.store(key.lo, std::memory_order_relaxed);
+        slot.key_hi.store(key.hi, std::memory_order_relaxed);
+        slot.turn.store(pack_turn(turn), std::memory_order_relaxed);
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void TurnCache::add_lookups(uint64_t lookups, uint64_t hits)
+    {
+        lookups_.fetch_add(lookups, std::memory_order_relaxed);
+        hits_.fetch_add(hits, std::memory_order_relaxed);
+    }
+
+    TurnCacheStats TurnCache::get_stats() const
+    {
+        TurnCacheStats stats;
+        stats.lookups = lookups_.load(std::memory_order_relaxed);
+        stats.hits = hits_.load(std::memory_order_relaxed);
+        stats.bytes = (slots_mask_ + 1) * sizeof(Slot);
+        return stats;
+    }
+
+} // namespace TheGameAnalyzer
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "turn.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace TheGameAnalyzer
+{
+    // Exact, compact encoding of the inputs of a turn search.
+    struct TurnCacheKey
+    {
+        uint64_t lo{0};
+        uint64_t hi{0};
+    };
+    bool operator==(const TurnCacheKey &k1, const TurnCacheKey &k2);
+
+    // Encode a turn search position. (Engine is any small id for the turn engine used.)
+    TurnCacheKey make_turn_cache_key(const Piles &piles, const Hand &hand, int min_cards_for_turn,
+                                     int card_reach_distance, unsigned engine);
+
+    struct TurnCacheStats
+    {
+        uint64_t lookups{0};
+        uint64_t hits{0};
+        size_t bytes{0}; // Memory used by the cache table.
+    };
+
+    // Fixed size, lock-free cache of turns shared by all threads.
+    //
+    // Direct mapped: each key has one slot and a new entry replaces whatever
+    // was there. Each slot is guarded by its own sequence number (a seqlock),
+    // so readers never block, and a writer that finds a slot busy just drops
+    // its entry.
+    class TurnCache
+    {
+    public:
+        // \param max_bytes Upper bound on the memory used by the table.
+        explicit TurnCache(size_t max_bytes);
+
+        std::optional<Turn> find(const TurnCacheKey &key) const;
+        void insert(const TurnCacheKey &key, const Turn &turn);
+
+        // Threads count their own lookups and add them once (e.g. per game).
+        void add_lookups(uint64_t lookups, uint64_t hits);
+        TurnCacheStats get_stats() const;
+
+    private:
+        struct Slot
+        {
+            std::atomic<uint64_t> sequence{0}; // Odd while being written.
+            std::atomic<uint64_t> key_lo{0};
+            std::atomic<uint64_t> key_hi{0};
+            std::atomic<uint64_t> turn{0}; // Packed, 0 if empty.
+        };
+
+        Slot &get_slot(const TurnCacheKey &key) const;
+
+        std::unique_ptr<Slot[]> slots_;
+        size_t slots_mask_{0};
+        std::atomic<uint64_t> lookups_{0};
+        std::atomic<uint64_t> hits_{0};
+    };
+
+} // namespace TheGameAnalyzer
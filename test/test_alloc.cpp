@@ -0,0 +1,108 @@
+#include "game.hpp"
+#include "turn.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+using namespace TheGameAnalyzer;
+
+// Count every heap allocation made by the program.
+static size_t num_allocations = 0;
+
+void *operator new(size_t size)
+{
+    ++num_allocations;
+    if (void *p = std::malloc(size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    ++num_allocations;
+    return std::malloc(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+int test_find_best_turn_no_allocations()
+{
+    struct TestCase
+    {
+        Piles piles;
+        Hand hand;
+        int min_cards_for_turn;
+        int card_reach_distance;
+    };
+
+    const TestCase test_cases[] = {
+        {{1, 1, 100, 100}, {2, 8, 11, 20, 24, 53, 57, 92}, 2, 1},
+        {{1, 8, 100, 100}, {6, 11, 20, 24, 51, 53, 57, 92}, 2, 1},
+        {{19, 61, 73, 81}, {3, 13, 37, 65, 74, 89, 95, 96}, 2, 3},
+        {{30, 93, 42, 71}, {3, 4, 5, 12, 13, 14, 15, 50}, 1, 5},
+        {{30, 93, 14, 71}, {3, 13, 46}, 1, 1},
+    };
+    int num_fails = 0;
+    for (const auto &tc : test_cases)
+    {
+        const auto num_allocations_before = num_allocations;
+        const auto turn = find_best_turn(tc.piles, tc.hand, tc.min_cards_for_turn, tc.card_reach_distance);
+        const auto num_allocations_act = num_allocations - num_allocations_before;
+        if (num_allocations_act != 0)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(piles: " << to_string(tc.piles)
+                      << ", hand: " << to_string(tc.hand)
+                      << "), turn: " << to_string(turn)
+                      << ", allocations: " << num_allocations_act << '\n';
+        }
+    }
+    return num_fails;
+}
+
+int test_play_game_no_allocations()
+{
+    int num_fails = 0;
+    for (const auto turn_engine : {TurnEngine::Greedy, TurnEngine::Exhaustive})
+    {
+        for (int num_players = MIN_PLAYERS; num_players <= MAX_PLAYERS; ++num_players)
+        {
+            for (uint32_t seed = 0; seed < 20; ++seed)
+            {
+                const auto num_allocations_before = num_allocations;
+                play_game(seed, num_players, 1, 3, PrintGame::No, turn_engine);
+                const auto num_allocations_act = num_allocations - num_allocations_before;
+                if (num_allocations_act != 0)
+                {
+                    ++num_fails;
+                    std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                              << "(seed: " << seed
+                              << ", num_players: " << num_players
+                              << ", turn_engine: " << static_cast<int>(turn_engine)
+                              << "), allocations: " << num_allocations_act << '\n';
+                }
+            }
+        }
+    }
+    return num_fails;
+}
+
+int main()
+{
+    const int num_fails = test_find_best_turn_no_allocations() +
+                          test_play_game_no_allocations();
+
+    return num_fails != 0;
+}
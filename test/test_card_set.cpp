@@ -0,0 +1,173 @@
+#include "card_set.hpp"
+
+#include <iostream>
+
+using namespace TheGameAnalyzer;
+
+int test_card_set_queries()
+{
+    struct TestCase
+    {
+        Hand hand;
+        Card card;
+        bool exp_contains;
+        size_t exp_rank;
+        Hand exp_above;
+        Hand exp_below;
+    };
+
+    const TestCase test_cases[] = {
+        {{}, 50, false, 0, {}, {}},
+        {{1}, 1, true, 0, {}, {}},
+        {{100}, 99, false, 0, {100}, {}},
+        {{2, 63, 64, 65, 99}, 64, true, 2, {65, 99}, {2, 63}},
+        {{2, 63, 64, 65, 99}, 66, false, 4, {99}, {2, 63, 64, 65}},
+        {{2, 11, 12, 21, 127}, 0, false, 0, {2, 11, 12, 21, 127}, {}},
+        {{2, 11, 12, 21, 127}, 127, true, 4, {}, {2, 11, 12, 21}},
+    };
+    int num_fails = 0;
+    for (const auto &tc : test_cases)
+    {
+        const CardSet cards(tc.hand);
+        const bool act_contains = cards.contains(tc.card);
+        const size_t act_rank = cards.rank(tc.card);
+        const CardSet act_above = cards.above(tc.card);
+        const CardSet act_below = cards.below(tc.card);
+        if (tc.exp_contains != act_contains ||
+            tc.exp_rank != act_rank ||
+            CardSet(tc.exp_above) != act_above ||
+            CardSet(tc.exp_below) != act_below ||
+            static_cast<int>(tc.hand.size()) != cards.size())
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(hand: " << to_string(tc.hand)
+                      << ", card: " << tc.card << ")"
+                      << ", exp_contains: " << tc.exp_contains
+                      << ", act_contains: " << act_contains
+                      << ", exp_rank: " << tc.exp_rank
+                      << ", act_rank: " << act_rank
+                      << ", exp_above: " << to_string(tc.exp_above)
+                      << ", act_above: " << to_string(act_above)
+                      << ", exp_below: " << to_string(tc.exp_below)
+                      << ", act_below: " << to_string(act_below) << '\n';
+        }
+    }
+    return num_fails;
+}
+
+int test_card_set_lowest_highest()
+{
+    struct TestCase
+    {
+        Hand hand;
+        Card exp_lowest;
+        Card exp_highest;
+    };
+
+    const TestCase test_cases[] = {
+        {{1}, 1, 1},
+        {{63}, 63, 63},
+        {{64}, 64, 64},
+        {{2, 99}, 2, 99},
+        {{70, 80, 127}, 70, 127},
+        {{0, 5, 63}, 0, 63},
+    };
+    int num_fails = 0;
+    for (const auto &tc : test_cases)
+    {
+        const CardSet cards(tc.hand);
+        const auto act_lowest = cards.lowest();
+        const auto act_highest = cards.highest();
+        if (tc.exp_lowest != act_lowest || tc.exp_highest != act_highest)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(hand: " << to_string(tc.hand) << ")"
+                      << ", exp_lowest: " << tc.exp_lowest
+                      << ", act_lowest: " << act_lowest
+                      << ", exp_highest: " << tc.exp_highest
+                      << ", act_highest: " << act_highest << '\n';
+        }
+    }
+    return num_fails;
+}
+
+int test_card_set_shifts()
+{
+    struct TestCase
+    {
+        Hand hand;
+        Hand exp_has_10_above;
+        Hand exp_has_10_below;
+    };
+
+    const TestCase test_cases[] = {
+        {{2}, {}, {}},
+        {{2, 12}, {2}, {12}},
+        {{2, 12, 22, 35}, {2, 12}, {12, 22}},
+        {{25, 30, 35, 40}, {25, 30}, {35, 40}},
+    };
+    int num_fails = 0;
+    for (const auto &tc : test_cases)
+    {
+        const CardSet cards(tc.hand);
+        const CardSet act_has_10_above = cards & cards.shifted_down(10);
+        const CardSet act_has_10_below = cards & cards.shifted_up(10);
+        if (CardSet(tc.exp_has_10_above) != act_has_10_above ||
+            CardSet(tc.exp_has_10_below) != act_has_10_below)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(hand: " << to_string(tc.hand) << ")"
+                      << ", exp_has_10_above: " << to_string(tc.exp_has_10_above)
+                      << ", act_has_10_above: " << to_string(act_has_10_above)
+                      << ", exp_has_10_below: " << to_string(tc.exp_has_10_below)
+                      << ", act_has_10_below: " << to_string(act_has_10_below) << '\n';
+        }
+    }
+    return num_fails;
+}
+
+int test_card_set_between()
+{
+    struct TestCase
+    {
+        Hand hand;
+        Card lo;
+        Card hi;
+        Hand exp;
+    };
+
+    const TestCase test_cases[] = {
+        {{4, 5, 6}, 3, 7, {4, 5, 6}},
+        {{4, 5, 6}, 4, 6, {5}},
+        {{4, 5, 6}, 5, 6, {}},
+        {{2, 63, 64, 65, 99}, 2, 99, {63, 64, 65}},
+        {{2, 63, 64, 65, 99}, 63, 100, {64, 65, 99}},
+    };
+    int num_fails = 0;
+    for (const auto &tc : test_cases)
+    {
+        const CardSet act = CardSet(tc.hand).between(tc.lo, tc.hi);
+        if (CardSet(tc.exp) != act)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(hand: " << to_string(tc.hand) << ", lo: " << tc.lo << ", hi: " << tc.hi << ")"
+                      << ", exp: " << to_string(tc.exp)
+                      << ", act: " << to_string(act) << '\n';
+        }
+    }
+    return num_fails;
+}
+
+int main()
+{
+    const int num_fails = test_card_set_queries() +
+                          test_card_set_lowest_highest() +
+                          test_card_set_shifts() +
+                          test_card_set_between();
+
+    return num_fails != 0;
+}
@@ -0,0 +1,207 @@
+#include "deck.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+using namespace TheGameAnalyzer;
+
+// The compatibility shuffle gives the decks std::shuffle gives with libstdc++.
+int test_shuffle_std_compat()
+{
+    int num_fails = 0;
+    for (uint32_t seed = 0; seed < 1000; ++seed)
+    {
+        Deck exp(NUM_CARDS_IN_DECK);
+        std::iota(exp.begin(), exp.end(), 2);
+        std::mt19937 gen32(seed);
+        std::shuffle(exp.begin(), exp.end(), gen32);
+
+        const ShuffledDeck act(seed, DeckRng::StdCompat);
+        if (exp != act.get_cards())
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(seed: " << seed << ")"
+                      << ", exp: " << to_string(exp)
+                      << ", act: " << to_string(act.get_cards()) << '\n';
+        }
+    }
+    return num_fails;
+}
+
+int test_shuffled_deck_xoshiro256()
+{
+    struct TestCase
+    {
+        uint32_t seed;
+        Hand exp_first_cards; // First 8 cards drawn.
+    };
+
+    const TestCase test_cases[] = {
+        {0, {60, 74, 11, 41, 70, 94, 40, 50}},
+        {1, {70, 52, 57, 39, 67, 15, 8, 36}},
+        {12345, {74, 14, 94, 6, 54, 2, 16, 28}},
+    };
+    int num_fails = 0;
+    for (const auto &tc : test_cases)
+    {
+        // Drawing lazily gives the same cards as shuffling everything first.
+        ShuffledDeck lazy_deck(tc.seed, DeckRng::Xoshiro256);
+        ShuffledDeck deck(tc.seed, DeckRng::Xoshiro256);
+        deck.shuffle_rest();
+        Deck exp_cards = deck.get_cards();
+        std::reverse(exp_cards.begin(), exp_cards.end());
+        Deck act_cards;
+        while (!lazy_deck.empty())
+        {
+            act_cards.push_back(lazy_deck.draw());
+        }
+        Deck sorted_cards = act_cards;
+        std::sort(sorted_cards.begin(), sorted_cards.end());
+        Deck all_cards(NUM_CARDS_IN_DECK);
+        std::iota(all_cards.begin(), all_cards.end(), 2);
+        const Hand act_first_cards(act_cards.begin(), act_cards.begin() + tc.exp_first_cards.size());
+
+        if (exp_cards != act_cards || sorted_cards != all_cards || tc.exp_first_cards != act_first_cards)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(seed: " << tc.seed << ")"
+                      << ", exp: " << to_string(exp_cards)
+                      << ", act: " << to_string(act_cards)
+                      << ", exp_first_cards: " << to_string(tc.exp_first_cards) << '\n';
+        }
+    }
+    return num_fails;
+}
+
+int test_get_bounded()
+{
+    int num_fails = 0;
+    Xoshiro256 rng(7);
+    for (uint32_t range : {1u, 2u, 3u, 98u, 1000u, 0x80000001u})
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            const auto act = get_bounded(rng, range);
+            if (act >= range)
+            {
+                ++num_fails;
+                std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                          << "(range: " << range << "), act: " << act << '\n';
+                break;
+            }
+        }
+    }
+    return num_fails;
+}
+
+// A corpus gives back the decks it was written from.
+int test_deck_corpus()
+{
+    const std::string path = "test_deck_corpus.bin";
+    int num_fails = 0;
+    for (const auto deck_rng : {DeckRng::StdCompat, DeckRng::Xoshiro256})
+    {
+        write_deck_corpus(path, 50, deck_rng);
+        const DeckCorpus deck_corpus(path);
+        if (deck_corpus.size() != 50)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << ", exp size: 50, act: " << deck_corpus.size() << '\n';
+            continue;
+        }
+        for (uint32_t seed = 0; seed < deck_corpus.size(); ++seed)
+        {
+            ShuffledDeck exp(seed, deck_rng);
+            ShuffledDeck act = deck_corpus.get_deck(seed);
+            bool is_same = true;
+            while (!exp.empty() && !act.empty())
+            {
+                is_same = is_same && exp.draw() == act.draw();
+            }
+            if (!is_same || !exp.empty() || !act.empty())
+            {
+                ++num_fails;
+                std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                          << "(seed: " << seed
+                          << ", deck_rng: " << to_string(deck_rng) << ")\n";
+            }
+        }
+    }
+    std::remove(path.c_str());
+    return num_fails;
+}
+
+// A file that isn't whole decks of cards [2 - 99] is rejected.
+int test_deck_corpus_bad_file()
+{
+    const std::string path = "test_deck_corpus_bad.bin";
+    Deck deck(NUM_CARDS_IN_DECK);
+    std::iota(deck.begin(), deck.end(), 2);
+    Deck duplicate_card = deck;
+    duplicate_card[5] = duplicate_card[6];
+    Deck card_too_high = deck;
+    card_too_high[0] = 100;
+
+    struct TestCase
+    {
+        std::vector<Deck> decks;
+        size_t num_extra_bytes;
+    };
+
+    const TestCase test_cases[] = {
+        {{}, 0},
+        {{deck}, 1},
+        {{deck, duplicate_card}, 0},
+        {{card_too_high}, 0},
+    };
+    int num_fails = 0;
+    for (const auto &tc : test_cases)
+    {
+        {
+            std::ofstream ofs(path, std::ios::binary);
+            for (const auto &d : tc.decks)
+            {
+                for (const auto c : d)
+                {
+                    ofs.put(static_cast<char>(c));
+                }
+            }
+            for (size_t i = 0; i < tc.num_extra_bytes; ++i)
+            {
+                ofs.put(2);
+            }
+        }
+        try
+        {
+            const DeckCorpus deck_corpus(path);
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(num_decks: " << tc.decks.size()
+                      << ", num_extra_bytes: " << tc.num_extra_bytes << "), no error\n";
+        }
+        catch (const std::runtime_error &)
+        {
+        }
+    }
+    std::remove(path.c_str());
+    return num_fails;
+}
+
+int main()
+{
+    const int num_fails = test_shuffle_std_compat() +
+                          test_shuffled_deck_xoshiro256() +
+                          test_get_bounded() +
+                          test_deck_corpus() +
+                          test_deck_corpus_bad_file();
+
+    return num_fails != 0;
+}
@@ -0,0 +1,155 @@
+#include "endgame.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace TheGameAnalyzer;
+
+int test_endgame_solver()
+{
+    struct TestCase
+    {
+        Piles piles;
+        Hand hand;
+        int exp;
+    };
+
+    const TestCase test_cases[] = {
+        {{1, 1, 100, 100}, {50, 60}, 0},
+        {{95, 95, 5, 5}, {50, 60}, 2},
+        {{40, 95, 50, 100}, {30, 45}, 0},           // 10 back on an ascending pile.
+        {{90, 90, 10, 10}, {20, 80, 85}, 0},        // 10 back on both piles opens 85.
+        {{90, 90, 10, 10}, {20, 50}, 1},
+        {{44, 99, 24, 18}, {6, 14, 25, 34, 66}, 0}, // find_best_turn() leaves 1.
+        {{1, 1, 100, 100}, {}, 0},
+    };
+    int num_fails = 0;
+    for (const auto &tc : test_cases)
+    {
+        EndgameSolver endgame_solver;
+        const int act = endgame_solver.solve(tc.piles, tc.hand);
+        if (tc.exp != act)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(piles: " << to_string(tc.piles)
+                      << ", hand: " << to_string(tc.hand) << ")"
+                      << ", exp: " << tc.exp
+                      << ", act: " << act << '\n';
+        }
+    }
+    return num_fails;
+}
+
+// The two piles of each direction are interchangeable.
+int test_make_endgame_key()
+{
+    const CardSet hand(Hand{2, 50, 64, 99});
+    const EndgameKey key = make_endgame_key({1, 30, 100, 70}, hand);
+    int num_fails = 0;
+    if (!(key == make_endgame_key({30, 1, 70, 100}, hand)) ||
+        key == make_endgame_key({1, 30, 100, 71}, hand) ||
+        key == make_endgame_key({1, 30, 100, 70}, CardSet(Hand{2, 50, 65, 99})))
+    {
+        ++num_fails;
+        std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__ << '\n';
+    }
+    return num_fails;
+}
+
+// The perfect endgame never loses to the heuristic, the same serially and in
+// parallel, and a written tablebase gives the same report.
+int test_play_games_endgame()
+{
+    const std::string path = "test_endgame_tablebase.bin";
+    const uint64_t NUM_TRIALS = 500;
+    int num_fails = 0;
+    const auto serial = play_games_endgame(1, 3, NUM_TRIALS, false);
+    const auto parallel = play_games_endgame(1, 3, NUM_TRIALS, true);
+    write_endgame_tablebase(path, 1, NUM_TRIALS, DeckRng::StdCompat);
+    const EndgameTablebase tablebase(path);
+    const auto from_tablebase = play_games_endgame(1, 3, NUM_TRIALS, true, &tablebase);
+    if (to_string(serial) != to_string(parallel) || to_string(serial) != to_string(from_tablebase) ||
+        tablebase.size() == 0 || serial.cards_lost_average < 0.0 ||
+        serial.perfect.cards_left_average > serial.heuristic.cards_left_average)
+    {
+        ++num_fails;
+        std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                  << ", serial: " << to_string(serial)
+                  << ", parallel: " << to_string(parallel)
+                  << ", from_tablebase: " << to_string(from_tablebase)
+                  << ", tablebase size: " << tablebase.size() << '\n';
+    }
+
+    // Every position of the tablebase is what a fresh search gives.
+    EndgameSolver endgame_solver;
+    EndgameSolver endgame_solver_with_tablebase(&tablebase);
+    for (uint32_t seed = 0; seed < NUM_TRIALS; ++seed)
+    {
+        const ShuffledDeck deck(seed, DeckRng::StdCompat);
+        const int exp = play_game(deck, 1, 1, 3, TurnEngine::Greedy, nullptr, Strategy::Basic, &endgame_solver);
+        const int act = play_game(deck, 1, 1, 3, TurnEngine::Greedy, nullptr, Strategy::Basic,
+                                  &endgame_solver_with_tablebase);
+        if (exp != act)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(seed: " << seed << ")"
+                      << ", exp: " << exp
+                      << ", act: " << act << '\n';
+        }
+    }
+    if (endgame_solver_with_tablebase.size() != 0)
+    {
+        ++num_fails;
+        std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                  << ", searched " << endgame_solver_with_tablebase.size() << " positions in the tablebase\n";
+    }
+    std::remove(path.c_str());
+    return num_fails;
+}
+
+int test_endgame_tablebase_errors()
+{
+    const std::string path = "test_endgame_tablebase_bad.bin";
+    int num_fails = 0;
+    // Empty, no size, one position missing, and a size whose bytes overflow
+    // to the file size (17 * 0xf0f0f0f0f0f0f0f1 is 1, modulo 2^64).
+    const std::string bad_contents[] = {
+        "",
+        "TGAEGTB1",
+        std::string("TGAEGTB1\x01\0\0\0\0\0\0\0", 16),
+        std::string("TGAEGTB1\xf1\xf0\xf0\xf0\xf0\xf0\xf0\xf0\0", 17),
+    };
+    for (const auto &contents : bad_contents)
+    {
+        {
+            std::ofstream ofs(path, std::ios::binary);
+            ofs.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        }
+        try
+        {
+            const EndgameTablebase tablebase(path);
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(contents size: " << contents.size() << "), no error\n";
+        }
+        catch (const std::runtime_error &)
+        {
+        }
+    }
+    std::remove(path.c_str());
+    return num_fails;
+}
+
+int main()
+{
+    const int num_fails = test_endgame_solver() +
+                          test_make_endgame_key() +
+                          test_play_games_endgame() +
+                          test_endgame_tablebase_errors();
+
+    return num_fails != 0;
+}
@@ -0,0 +1,101 @@
+#include "exhaustive_turn.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace TheGameAnalyzer;
+
+int test_find_best_turn_exhaustive()
+{
+    struct TestCase
+    {
+        Piles piles;
+        Hand hand;
+        int min_cards_for_turn;
+        int card_reach_distance;
+        Turn exp;
+    };
+
+    const TestCase test_cases[] = {
+        // Same as greedy.
+        {{1, 8, 100, 100}, {6, 11, 20, 24, 51, 53, 57, 92}, 2, 1, {{6, 11, 100, 100}, 0x3, 8, {1, 1, 0, 0}, false}},
+        {{1, 1, 100, 100}, {2, 3, 5, 50, 96, 98}, 2, 3, {{1, 5, 96, 100}, 0x37, 8, {0, 3, 2, 0}, false}},
+        {{1, 1, 100, 78}, {84, 88, 94}, 2, 0, {{1, 1, 100, 94}, 0x7, -16, {0, 0, 0, 3}, false}},
+        // Better than greedy: 21 -> 27 -> 30 -> 20 instead of a separate pile.
+        {{26, 21, 56, 92}, {3, 16, 20, 27, 30, 46, 50, 53}, 2, 0, {{16, 20, 56, 92}, 0x1e, -11, {1, 3, 0, 0}, false}},
+        // Better than greedy: 79 -> 89 -> 87 -> 97.
+        {{16, 11, 79, 64}, {40, 73, 75, 82, 87, 89, 95, 97}, 1, 0, {{16, 11, 97, 64}, 0xb0, -18, {0, 0, 3, 0}, false}},
+        // Better than greedy: one card on each descending pile.
+        {{20, 40, 81, 87}, {4, 64, 77, 91}, 2, 0, {{20, 40, 91, 77}, 0xc, 0, {0, 0, 1, 1}, false}},
+        // Can't play.
+        {{50, 50, 40, 40}, {45}, 1, 3, {{50, 50, 40, 40}, 0x0, 0, {0, 0, 0, 0}, false}},
+    };
+    int num_fails = 0;
+    for (const auto &tc : test_cases)
+    {
+        const auto act = find_best_turn_exhaustive(tc.piles, tc.hand, tc.min_cards_for_turn, tc.card_reach_distance);
+        if (tc.exp != act)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(piles: " << to_string(tc.piles)
+                      << ", hand: " << to_string(tc.hand)
+                      << ", min_cards: " << tc.min_cards_for_turn
+                      << ", crd: " << tc.card_reach_distance << ")"
+                      << ", exp: " << to_string(tc.exp)
+                      << ", act: " << to_string(act) << "\n";
+        }
+    }
+    return num_fails;
+}
+
+// The exhaustive turn (without reaching) is never worse than the greedy one.
+int test_find_best_turn_exhaustive_not_worse_than_greedy()
+{
+    std::mt19937 gen32(0);
+    int num_fails = 0;
+    for (int i = 0; i < 2000; ++i)
+    {
+        const Piles piles = {static_cast<Card>(1 + gen32() % 50), static_cast<Card>(1 + gen32() % 50),
+                             static_cast<Card>(51 + gen32() % 50), static_cast<Card>(51 + gen32() % 50)};
+        std::vector<Card> cards;
+        for (Card c = 2; c < 100; ++c)
+        {
+            if (std::find(piles.begin(), piles.end(), c) == piles.end())
+            {
+                cards.push_back(c);
+            }
+        }
+        std::shuffle(cards.begin(), cards.end(), gen32);
+        Hand hand(cards.begin(), cards.begin() + 1 + gen32() % MAX_HAND_SIZE);
+        std::sort(hand.begin(), hand.end());
+        const int min_cards_for_turn = 1 + static_cast<int>(gen32() % 2);
+
+        const auto greedy = find_best_turn(piles, hand, min_cards_for_turn, 0);
+        const auto exhaustive = find_best_turn_exhaustive(piles, hand, min_cards_for_turn, 0);
+        const bool greedy_has_min_cards = get_num_cards_in_hand_mask(greedy.hand_mask) >= min_cards_for_turn;
+        const bool exhaustive_has_min_cards = get_num_cards_in_hand_mask(exhaustive.hand_mask) >= min_cards_for_turn;
+        if ((greedy_has_min_cards && !exhaustive_has_min_cards) ||
+            (greedy_has_min_cards && greedy.delta < exhaustive.delta))
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(piles: " << to_string(piles)
+                      << ", hand: " << to_string(hand)
+                      << ", min_cards: " << min_cards_for_turn << ")"
+                      << ", greedy: " << to_string(greedy)
+                      << ", exhaustive: " << to_string(exhaustive) << "\n";
+        }
+    }
+    return num_fails;
+}
+
+int main()
+{
+    const int num_fails = test_find_best_turn_exhaustive() +
+                          test_find_best_turn_exhaustive_not_worse_than_greedy();
+
+    return num_fails != 0;
+}
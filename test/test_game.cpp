@@ -3,25 +3,24 @@
 #include "turn.hpp"
 
 #include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <numeric>
 #include <sstream>
+#include <utility>
 #include <vector>
 
 using namespace TheGameAnalyzer;
 
-namespace TheGameAnalyzer
-{
-    void draw_cards(std::vector<Card> &deck, Hand &hand, HandMask hand_mask);
-}
-
 int test_draw_cards()
 {
     struct TestCase
     {
-        std::vector<Card> deck;
+        Deck deck;
         Hand hand;
         HandMask hand_mask;
-        std::vector<Card> exp_deck;
+        Deck exp_deck;
         Hand exp_hand;
     };
     const TestCase test_cases[] = {
@@ -29,11 +28,13 @@ int test_draw_cards()
         {{7}, {26, 29, 93}, 0x4, {}, {7, 26, 29}},
         {{7}, {26, 29, 93}, 0x6, {}, {7, 26}},
         {{7}, {26, 29, 93}, 0x3, {}, {7, 93}},
+        {{50, 2, 99}, {26, 29, 93}, 0x7, {}, {2, 50, 99}},
+        {{50, 2, 99}, {26, 29, 93}, 0x2, {50, 2}, {26, 93, 99}},
     };
     int num_fails = 0;
     for (const auto &tc : test_cases)
     {
-        std::vector<Card> act_deck = tc.deck;
+        Deck act_deck = tc.deck;
         Hand act_hand = tc.hand;
         draw_cards(act_deck, act_hand, tc.hand_mask);
         if (tc.exp_deck != act_deck || tc.exp_hand != act_hand)
@@ -92,10 +93,287 @@ int test_calculate_games_stats()
     return num_fails;
 }
 
+// Merging partial stats in any order gives exactly the stats of all games.
+int test_games_stats_merge()
+{
+    const std::vector<int> num_cards_played = {11, 4, 0, 7, 98, 0, 3, 9, 10, 45, 2, 2, 61};
+    const auto exp = calculate_games_stats(num_cards_played);
+    int num_fails = 0;
+    for (size_t split = 0; split <= num_cards_played.size(); ++split)
+    {
+        GamesStats gs1;
+        GamesStats gs2;
+        for (size_t i = 0; i < num_cards_played.size(); ++i)
+        {
+            (i < split ? gs1 : gs2).add(num_cards_played[i]);
+        }
+        GamesStats gs12 = gs1;
+        gs12.merge(gs2);
+        GamesStats gs21 = gs2;
+        gs21.merge(gs1);
+        for (const auto &gs : {gs12, gs21})
+        {
+            const auto act = calculate_games_stats(gs);
+            if (to_string(exp) != to_string(act) || !close_enough(exp, act, 0.0))
+            {
+                ++num_fails;
+                std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                          << "(split: " << split << ")"
+                          << ", exp: " << to_string(exp)
+                          << ", act: " << to_string(act) << '\n';
+            }
+        }
+    }
+    return num_fails;
+}
+
+// The same results whichever way the trials are run.
+int test_play_games_deterministic()
+{
+    int num_fails = 0;
+    for (int num_players = MIN_PLAYERS; num_players <= MAX_PLAYERS; ++num_players)
+    {
+        const auto exp = play_games(num_players, 1, 3, 777, false);
+        for (const unsigned num_threads : {0u, 1u, 3u})
+        {
+            const auto act = play_games(num_players, 1, 3, 777, true, TurnEngine::Greedy, 0, DeckRng::StdCompat,
+                                        nullptr, {num_threads, false});
+            if (to_string(exp) != to_string(act))
+            {
+                ++num_fails;
+                std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                          << "(num_players: " << num_players
+                          << ", num_threads: " << num_threads << ")"
+                          << ", exp: " << to_string(exp)
+                          << ", act: " << to_string(act) << '\n';
+            }
+        }
+    }
+    return num_fails;
+}
+
+// CardMemory keeps its played cards per game: a shared turn cache gives
+// the same results as play_game().
+int test_play_game_card_memory()
+{
+    int num_fails = 0;
+    std::vector<uint32_t> seeds(101);
+    std::iota(seeds.begin(), seeds.end(), 2000);
+    for (int num_players = MIN_PLAYERS; num_players <= MAX_PLAYERS; ++num_players)
+    {
+        TurnCache turn_cache(1 << 20);
+        for (size_t i = 0; i < seeds.size(); ++i)
+        {
+            const int exp = play_game(seeds[i], num_players, 2, 5, PrintGame::No, TurnEngine::Greedy, nullptr,
+                                      DeckRng::StdCompat, Strategy::CardMemory);
+            const int act_cached = play_game(seeds[i], num_players, 2, 5, PrintGame::No, TurnEngine::Greedy,
+                                             &turn_cache, DeckRng::StdCompat, Strategy::CardMemory);
+            if (exp != act_cached)
+            {
+                ++num_fails;
+                std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                          << "(seed: " << seeds[i]
+                          << ", num_players: " << num_players
+                          << "), exp: " << exp
+                          << ", act cached: " << act_cached << '\n';
+            }
+        }
+    }
+    return num_fails;
+}
+
+// A forked game gives the same result as play_game() for every configuration.
+int test_play_game_forked()
+{
+    std::vector<CardReachDistances> configs;
+    for (int r = 0; r <= 6; ++r)
+    {
+        for (int e = r; e <= 13; ++e)
+        {
+            configs.push_back({r, e});
+        }
+    }
+    int num_fails = 0;
+    for (const auto turn_engine : {TurnEngine::Greedy, TurnEngine::Exhaustive})
+    {
+        const uint32_t num_seeds = turn_engine == TurnEngine::Greedy ? 40 : 4;
+        for (int num_players = MIN_PLAYERS; num_players <= MAX_PLAYERS; ++num_players)
+        {
+            for (uint32_t seed = 0; seed < num_seeds; ++seed)
+            {
+                std::vector<int> num_cards_remaining(configs.size(), -1);
+                play_game_forked(ShuffledDeck(seed, DeckRng::StdCompat), num_players, configs.data(), configs.size(),
+                                 turn_engine, num_cards_remaining.data());
+                for (size_t i = 0; i < configs.size(); ++i)
+                {
+                    const int exp = play_game(seed, num_players, configs[i].normal, configs[i].endgame,
+                                              PrintGame::No, turn_engine);
+                    if (exp != num_cards_remaining[i])
+                    {
+                        ++num_fails;
+                        std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                                  << "(seed: " << seed
+                                  << ", num_players: " << num_players
+                                  << ", r: " << configs[i].normal
+                                  << ", e: " << configs[i].endgame
+                                  << ", turn_engine: " << static_cast<int>(turn_engine)
+                                  << "), exp: " << exp
+                                  << ", act: " << num_cards_remaining[i] << '\n';
+                    }
+                }
+            }
+        }
+    }
+    return num_fails;
+}
+
+// Playing decks from a corpus gives the same results as shuffling them.
+int test_play_games_deck_corpus()
+{
+    const std::string path = "test_game_deck_corpus.bin";
+    int num_fails = 0;
+    for (const auto deck_rng : {DeckRng::StdCompat, DeckRng::Xoshiro256})
+    {
+        write_deck_corpus(path, 300, deck_rng);
+        const DeckCorpus deck_corpus(path);
+        for (int num_players = MIN_PLAYERS; num_players <= MAX_PLAYERS; ++num_players)
+        {
+            const auto exp = play_games(num_players, 2, 4, 300, false, TurnEngine::Greedy, 0, deck_rng);
+            const auto act = play_games(num_players, 2, 4, 300, true, TurnEngine::Greedy, 0, deck_rng,
+                                        &deck_corpus);
+            if (to_string(exp) != to_string(act))
+            {
+                ++num_fails;
+                std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                          << "(num_players: " << num_players
+                          << ", deck_rng: " << to_string(deck_rng) << ")"
+                          << ", exp: " << to_string(exp)
+                          << ", act: " << to_string(act) << '\n';
+            }
+        }
+    }
+    std::remove(path.c_str());
+    return num_fails;
+}
+
+// A decoded trace prints the same games as PrintGame::Yes.
+int test_game_trace()
+{
+    const std::string trace_path = "test_game_trace.bin";
+    const std::string corpus_path = "test_game_trace_corpus.bin";
+    const uint64_t num_trials = 20;
+    int num_fails = 0;
+    for (const auto deck_rng : {DeckRng::StdCompat, DeckRng::Xoshiro256})
+    {
+        write_deck_corpus(corpus_path, num_trials, deck_rng);
+        const DeckCorpus deck_corpus(corpus_path);
+        for (int num_players = MIN_PLAYERS; num_players <= MAX_PLAYERS; ++num_players)
+        {
+            std::ostringstream exp;
+            auto *const cout_buf = std::cout.rdbuf(exp.rdbuf());
+            for (uint32_t seed = 0; seed < num_trials; ++seed)
+            {
+                const int num_cards_remaining = play_game(seed, num_players, 2, 4, PrintGame::Yes, TurnEngine::Greedy,
+                                                          nullptr, deck_rng);
+                exp << "Cards remaining: " << num_cards_remaining << "\n";
+            }
+            std::cout.rdbuf(cout_buf);
+            for (const DeckCorpus *corpus : {static_cast<const DeckCorpus *>(nullptr), &deck_corpus})
+            {
+                {
+                    GameTraceFile game_trace(trace_path);
+                    play_games(num_players, 2, 4, num_trials, false, TurnEngine::Greedy, 0, deck_rng, corpus, {},
+                               &game_trace);
+                    game_trace.close();
+                }
+                std::ifstream is(trace_path, std::ios::binary);
+                std::ostringstream act;
+                decode_game_trace(is, act);
+                if (exp.str() != act.str())
+                {
+                    ++num_fails;
+                    std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                              << "(num_players: " << num_players
+                              << ", deck_rng: " << to_string(deck_rng)
+                              << ", corpus: " << (corpus != nullptr) << ")"
+                              << ", exp: " << exp.str()
+                              << ", act: " << act.str() << '\n';
+                }
+            }
+        }
+    }
+    std::remove(trace_path.c_str());
+    std::remove(corpus_path.c_str());
+    return num_fails;
+}
+
+// Writing a trace to a full disk is an error when the trace is closed.
+int test_game_trace_write_error()
+{
+    int num_fails = 0;
+    try
+    {
+        GameTraceFile game_trace("/dev/full");
+        play_games(1, 2, 4, 100, false, TurnEngine::Greedy, 0, DeckRng::StdCompat, nullptr, {}, &game_trace);
+        game_trace.close();
+        ++num_fails;
+        std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__ << ", no error\n";
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    return num_fails;
+}
+
+// A schedule of the normal reach, then the endgame reach, is play_game(),
+// and each stage of a schedule covers its range of deck sizes.
+int test_play_game_reach_schedule()
+{
+    int num_fails = 0;
+    const ReachSchedule reach_schedule{{4, 3, 2, 1}};
+    const std::pair<size_t, int> stages[] = {{98, 4}, {64, 4}, {63, 3}, {32, 3}, {31, 2}, {1, 2}, {0, 1}};
+    for (const auto &[num_cards_in_deck, exp] : stages)
+    {
+        const int act = reach_schedule.get(num_cards_in_deck);
+        if (exp != act)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(num_cards_in_deck: " << num_cards_in_deck << ")"
+                      << ", exp: " << exp << ", act: " << act << '\n';
+        }
+    }
+    for (int num_players = MIN_PLAYERS; num_players <= MAX_PLAYERS; ++num_players)
+    {
+        for (uint32_t seed = 0; seed < 50; ++seed)
+        {
+            const ShuffledDeck deck(seed, DeckRng::StdCompat);
+            const int exp = play_game(deck, num_players, 2, 5, TurnEngine::Greedy, nullptr, Strategy::ReachNearGroupCard);
+            const int act = play_game(deck, num_players, make_reach_schedule(2, 5), Strategy::ReachNearGroupCard);
+            if (exp != act)
+            {
+                ++num_fails;
+                std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                          << "(num_players: " << num_players << ", seed: " << seed << ")"
+                          << ", exp: " << exp << ", act: " << act << '\n';
+            }
+        }
+    }
+    return num_fails;
+}
+
 int main()
 {
     const int num_fails = test_draw_cards() +
-                          test_calculate_games_stats();
+                          test_calculate_games_stats() +
+                          test_games_stats_merge() +
+                          test_play_games_deterministic() +
+                          test_play_game_card_memory() +
+                          test_play_game_forked() +
+                          test_play_games_deck_corpus() +
+                          test_game_trace() +
+                          test_game_trace_write_error() +
+                          test_play_game_reach_schedule();
 
     return num_fails != 0;
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "lookahead.hpp"
+
+#include <iostream>
+
+using namespace TheGameAnalyzer;
+
+// With no samples the lookahead player is the greedy player.
+int test_play_game_lookahead_no_samples()
+{
+    int num_fails = 0;
+    for (int num_players = MIN_PLAYERS; num_players <= MAX_PLAYERS; ++num_players)
+    {
+        for (uint32_t seed = 0; seed < 50; ++seed)
+        {
+            const ShuffledDeck deck(seed, DeckRng::StdCompat);
+            const int exp = play_game(deck, num_players, 1, 3);
+            const int act = play_game_lookahead(deck, num_players, 1, 3, {0}, seed);
+            if (exp != act)
+            {
+                ++num_fails;
+                std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                          << "(num_players: " << num_players << ", seed: " << seed << ")"
+                          << ", exp: " << exp << ", act: " << act << '\n';
+            }
+        }
+    }
+    return num_fails;
+}
+
+// Lookahead games are repeatable, the same serially and in parallel, and
+// leave fewer cards than the greedy player on average.
+int test_play_games_lookahead()
+{
+    const uint64_t NUM_TRIALS = 20;
+    const LookaheadOptions options{8};
+    int num_fails = 0;
+    for (const int num_players : {1, 3})
+    {
+        const auto greedy = play_games(num_players, 1, 3, NUM_TRIALS, true);
+        const auto serial = play_games_lookahead(num_players, 1, 3, NUM_TRIALS, false, options);
+        const auto parallel = play_games_lookahead(num_players, 1, 3, NUM_TRIALS, true, options);
+        if (to_string(serial) != to_string(parallel) || serial.cards_left_average >= greedy.cards_left_average)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(num_players: " << num_players << ")"
+                      << ", greedy: " << to_string(greedy)
+                      << ", serial: " << to_string(serial)
+                      << ", parallel: " << to_string(parallel) << '\n';
+        }
+    }
+    return num_fails;
+}
+
+int main()
+{
+    const int num_fails = test_play_game_lookahead_no_samples() +
+                          test_play_games_lookahead();
+
+    return num_fails != 0;
+}
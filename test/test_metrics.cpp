@@ -0,0 +1,99 @@
+#include "game.hpp"
+#include "metrics.hpp"
+
+#include <iostream>
+#include <string>
+
+using namespace TheGameAnalyzer;
+
+// Built with TGA_METRICS, play_games() counts every section: each game
+// shuffles one deck and deals once, and each greedy turn search gets the plays,
+// the best minimum cards and the reach cards once.
+int test_play_games_metrics()
+{
+    struct TestCase
+    {
+        int num_players;
+        uint64_t num_trials;
+        bool do_parallel;
+    };
+
+    const TestCase test_cases[] = {
+        {1, 100, false},
+        {3, 100, false},
+        {5, 1000, true},
+    };
+    int num_fails = 0;
+    for (const auto &tc : test_cases)
+    {
+        const auto results = play_games(tc.num_players, 1, 1, tc.num_trials, tc.do_parallel);
+        if (!results.metrics)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(num_players: " << tc.num_players << "), no metrics\n";
+            continue;
+        }
+        const auto &metrics = *results.metrics;
+        auto calls = [&](Metric metric)
+        { return metrics.calls[static_cast<size_t>(metric)]; };
+        auto cycles = [&](Metric metric)
+        { return metrics.cycles[static_cast<size_t>(metric)]; };
+        const bool ok = calls(Metric::DeckShuffle) == tc.num_trials &&
+                        calls(Metric::DealHands) == tc.num_trials &&
+                        calls(Metric::PilesOfPlays) > tc.num_trials &&
+                        calls(Metric::BestMinCards) == calls(Metric::PilesOfPlays) &&
+                        calls(Metric::ReachCards) == calls(Metric::PilesOfPlays) &&
+                        calls(Metric::DrawCards) > tc.num_trials &&
+                        cycles(Metric::PilesOfPlays) > 0 &&
+                        cycles(Metric::DrawCards) > 0;
+        if (!ok)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(num_players: " << tc.num_players
+                      << ", num_trials: " << tc.num_trials
+                      << ", do_parallel: " << tc.do_parallel << ")"
+                      << ", act: " << to_json(metrics) << '\n';
+        }
+    }
+    return num_fails;
+}
+
+int test_metrics_text()
+{
+    MetricsStats metrics;
+    metrics.calls[static_cast<size_t>(Metric::DrawCards)] = 12;
+    metrics.cycles[static_cast<size_t>(Metric::DrawCards)] = 3456;
+    const std::string text = to_metrics_text(metrics);
+    const std::string json = to_json(metrics);
+    int num_fails = 0;
+    for (const std::string exp : {"thegameanalyzer_calls_total{section=\"draw_cards\"} 12\n",
+                                  "thegameanalyzer_cycles_total{section=\"draw_cards\"} 3456\n",
+                                  "thegameanalyzer_calls_total{section=\"deck_shuffle\"} 0\n",
+                                  "thegameanalyzer_calls_total{section=\"deal_hands\"} 0\n",
+                                  "# TYPE thegameanalyzer_cycles_total counter\n"})
+    {
+        if (text.find(exp) == std::string::npos)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << ", exp: " << exp << ", act: " << text << '\n';
+        }
+    }
+    if (json.find("\"draw_cards_calls\": 12, \"draw_cards_cycles\": 3456") == std::string::npos)
+    {
+        ++num_fails;
+        std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                  << ", act: " << json << '\n';
+    }
+    return num_fails;
+}
+
+int main()
+{
+    const int num_fails = test_play_games_metrics() +
+                          test_metrics_text();
+
+    return num_fails != 0;
+}
@@ -0,0 +1,158 @@
+#include "optimizer.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace TheGameAnalyzer;
+
+namespace
+{
+    const uint64_t NUM_TRIALS = 128;
+
+    OptimizerOptions get_options(unsigned num_generations, const std::string &checkpoint_path = "")
+    {
+        OptimizerOptions options;
+        options.population_size = 8;
+        options.num_elites = 2;
+        options.num_generations = num_generations;
+        options.sample_seed = 7;
+        options.checkpoint_path = checkpoint_path;
+        return options;
+    }
+
+    // The search of get_options() for 1 player, from -r 1 -e 3.
+    OptimizerSearch get_search()
+    {
+        return {1, NUM_TRIALS, 1, 3, DeckRng::StdCompat, 8, 2, 7};
+    }
+} // namespace
+
+// The search is the same serially and in parallel, and its best is never
+// worse than the starting parameters on the training seeds.
+int test_optimize_strategy()
+{
+    int num_fails = 0;
+    for (const int num_players : {1, 3})
+    {
+        const auto baseline = play_games(num_players, 1, 3, NUM_TRIALS, true);
+        unsigned num_callbacks = 0;
+        const auto serial = optimize_strategy(num_players, 1, 3, NUM_TRIALS, false, get_options(3), DeckRng::StdCompat,
+                                              {}, [&](const OptimizerState &) { ++num_callbacks; });
+        const auto parallel = optimize_strategy(num_players, 1, 3, NUM_TRIALS, true, get_options(3));
+        if (to_json(serial.state) != to_json(parallel.state) || to_string(serial) != to_string(parallel) ||
+            serial.state.generation != 3 || num_callbacks != 3 || serial.state.population.size() != 8 ||
+            serial.state.best.cards_left_average > baseline.cards_left_average ||
+            to_string(serial.baseline_validation) == to_string(baseline))
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(num_players: " << num_players << ")"
+                      << ", baseline: " << to_string(baseline)
+                      << ", serial: " << to_json(serial.state) << to_string(serial)
+                      << ", parallel: " << to_json(parallel.state) << to_string(parallel)
+                      << ", num_callbacks: " << num_callbacks << '\n';
+        }
+    }
+    return num_fails;
+}
+
+// A search stopped after a checkpoint and resumed ends where an unbroken one does.
+int test_optimizer_checkpoint()
+{
+    const std::string path = "test_optimizer_checkpoint.txt";
+    std::remove(path.c_str());
+    int num_fails = 0;
+    const auto whole = optimize_strategy(1, 1, 3, NUM_TRIALS, true, get_options(4));
+    optimize_strategy(1, 1, 3, NUM_TRIALS, true, get_options(2, path));
+    const auto checkpoint = read_optimizer_checkpoint(path, get_search());
+    const auto resumed = optimize_strategy(1, 1, 3, NUM_TRIALS, true, get_options(4, path));
+    if (checkpoint.generation != 2 || checkpoint.population.size() != 8 ||
+        to_json(whole.state) != to_json(resumed.state) || to_string(whole) != to_string(resumed))
+    {
+        ++num_fails;
+        std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                  << ", checkpoint: " << to_json(checkpoint)
+                  << ", whole: " << to_json(whole.state)
+                  << ", resumed: " << to_json(resumed.state) << '\n';
+    }
+
+    // Another search can't resume from it.
+    std::vector<OptimizerSearch> other_searches(8, get_search());
+    ++other_searches[0].num_players;
+    ++other_searches[1].num_trials;
+    ++other_searches[2].card_reach_distance_normal;
+    ++other_searches[3].card_reach_distance_endgame;
+    other_searches[4].deck_rng = DeckRng::Xoshiro256;
+    ++other_searches[5].population_size;
+    ++other_searches[6].num_elites;
+    ++other_searches[7].sample_seed;
+    for (size_t i = 0; i < other_searches.size(); ++i)
+    {
+        try
+        {
+            read_optimizer_checkpoint(path, other_searches[i]);
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(other search: " << i << "), no error\n";
+        }
+        catch (const std::runtime_error &)
+        {
+        }
+    }
+    std::remove(path.c_str());
+    return num_fails;
+}
+
+int test_optimizer_checkpoint_errors()
+{
+    const std::string path = "test_optimizer_checkpoint_bad.txt";
+    int num_fails = 0;
+    const std::string search = "TGAOPT2\nnum_players 1\nnum_trials 128\ncard_reach_distance_normal 1\n"
+                               "card_reach_distance_endgame 3\ndeck_rng std-compat\npopulation_size 8\n"
+                               "num_elites 2\nsample_seed 7\n";
+    const std::string distribution = "generation 1\nreach_mean 1 1 1 3\nreach_stddev 1 1 1 1\n"
+                                     "skip_near_group_card_probability 0.5\n";
+    // Empty, not a checkpoint, the last version, cut short, a reach distance
+    // out of range, and populations too small, too big and cut short.
+    const std::string bad_contents[] = {
+        "",
+        "TGAEGTB1\n",
+        "TGAOPT1\nnum_players 1\nnum_trials 128\n",
+        search + "generation 1\nreach_mean 1 1 1\n",
+        search + distribution + "best 1 1 1 99 1 12.5\npopulation 0\n",
+        search + distribution + "best 1 1 1 3 1 12.5\npopulation 0\n",
+        search + distribution + "best 1 1 1 3 1 12.5\npopulation 1000000000000\n",
+        search + distribution + "best 1 1 1 3 1 12.5\npopulation 8\n1 1 1 3 1 12.5\n",
+    };
+    for (const auto &contents : bad_contents)
+    {
+        {
+            std::ofstream ofs(path);
+            ofs << contents;
+        }
+        try
+        {
+            read_optimizer_checkpoint(path, get_search());
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(contents: " << contents << "), no error\n";
+        }
+        catch (const std::runtime_error &)
+        {
+        }
+    }
+    std::remove(path.c_str());
+    return num_fails;
+}
+
+int main()
+{
+    const int num_fails = test_optimize_strategy() +
+                          test_optimizer_checkpoint() +
+                          test_optimizer_checkpoint_errors();
+
+    return num_fails != 0;
+}
@@ -0,0 +1,186 @@
+#include "perfect_solver.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+using namespace TheGameAnalyzer;
+
+// Small decks are solved to the optimum, which is never worse than the heuristic.
+int test_solve_perfect_small_decks()
+{
+    const size_t NUM_CARDS = 20;
+    const PerfectSolverOptions options{1000000};
+    int num_fails = 0;
+    Xoshiro256 rng(1);
+    for (int num_players = 1; num_players <= 2; ++num_players)
+    {
+        for (int i = 0; i < 100; ++i)
+        {
+            // The first NUM_CARDS cards of a shuffled deck.
+            Deck cards = ShuffledDeck(static_cast<uint32_t>(rng()), DeckRng::Xoshiro256).get_cards();
+            cards.resize(NUM_CARDS);
+            const ShuffledDeck deck(cards);
+            const int heuristic = play_game(deck, num_players, 1, 3);
+            // Start from the worst result, so the search has to find the heuristic's line or better.
+            const auto result = solve_perfect(deck, num_players, static_cast<int>(NUM_CARDS), options);
+            if (!result.is_optimal() || result.best > heuristic || result.best < 0)
+            {
+                ++num_fails;
+                std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                          << "(num_players: " << num_players << ", i: " << i << ")"
+                          << ", heuristic: " << heuristic
+                          << ", best: " << result.best
+                          << ", lower_bound: " << result.lower_bound
+                          << ", num_nodes: " << result.num_nodes << '\n';
+            }
+        }
+    }
+    return num_fails;
+}
+
+// Every card is playable in order, whatever the heuristic says.
+int test_solve_perfect_sorted_deck()
+{
+    Deck cards;
+    for (Card c = 2; c < 12; ++c)
+    {
+        cards.push_back(c);
+    }
+    std::reverse(cards.begin(), cards.end()); // Drawn from the back.
+    const ShuffledDeck deck(cards);
+    const auto result = solve_perfect(deck, 1, 10, {});
+    int num_fails = 0;
+    if (result.best != 0 || !result.is_optimal() || result.heuristic != 10)
+    {
+        ++num_fails;
+        std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                  << ", best: " << result.best
+                  << ", lower_bound: " << result.lower_bound
+                  << ", num_nodes: " << result.num_nodes << '\n';
+    }
+    return num_fails;
+}
+
+// Either pile of a direction can go 10 back, whichever is further along.
+int test_get_num_unreachable_cards()
+{
+    struct TestCase
+    {
+        Piles piles;
+        Hand cards;
+        int exp;
+    };
+    const TestCase test_cases[] = {
+        {{1, 1, 100, 100}, {2, 50, 99}, 0},
+        {{85, 92, 30, 40}, {82}, 0},         // 10 back from 92, though not from 85.
+        {{85, 92, 30, 40}, {72, 82}, 0},     // Chained on from 92.
+        {{85, 92, 30, 40}, {83}, 1},         // Not 10 back from either.
+        {{60, 70, 11, 20}, {21}, 0},         // 10 back from 11, though not from 20.
+        {{60, 70, 11, 20}, {22, 45, 61}, 2}, // Only 61 is reachable.
+    };
+    int num_fails = 0;
+    for (const auto &tc : test_cases)
+    {
+        const int act = get_num_unreachable_cards(tc.piles, CardSet(tc.cards));
+        if (act != tc.exp)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(piles: " << to_string(tc.piles) << ", cards: " << to_string(tc.cards) << ")"
+                      << ", exp: " << tc.exp
+                      << ", act: " << act << '\n';
+        }
+    }
+    return num_fails;
+}
+
+// The lower bound never prunes a line that a search without it finds. The
+// decks are cards from a narrow band, so the two piles of a direction end up
+// within 10 of each other and either can go 10 back.
+int test_solve_perfect_lower_bound()
+{
+    const size_t NUM_CARDS = 16;
+    const Card FIRST_CARD = 40;
+    const Card NUM_BAND_CARDS = 25;
+    int num_fails = 0;
+    Xoshiro256 rng(2);
+    PerfectSolverOptions options{10000000};
+    PerfectSolverOptions options_no_bound = options;
+    options_no_bound.use_lower_bound = false;
+    for (int num_players = 1; num_players <= 2; ++num_players)
+    {
+        for (int i = 0; i < 50; ++i)
+        {
+            Deck cards;
+            for (Card c = FIRST_CARD; c < FIRST_CARD + NUM_BAND_CARDS; ++c)
+            {
+                cards.push_back(c);
+            }
+            for (size_t j = cards.size(); j > 1; --j)
+            {
+                std::swap(cards[j - 1], cards[get_bounded(rng, static_cast<uint32_t>(j))]);
+            }
+            cards.resize(NUM_CARDS);
+            const ShuffledDeck deck(cards);
+            const auto exp = solve_perfect(deck, num_players, static_cast<int>(NUM_CARDS), options_no_bound);
+            const auto act = solve_perfect(deck, num_players, static_cast<int>(NUM_CARDS), options);
+            if (!exp.is_optimal() || !act.is_optimal() || exp.best != act.best)
+            {
+                ++num_fails;
+                std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                          << "(num_players: " << num_players << ", i: " << i << ")"
+                          << ", exp: " << to_json({exp})
+                          << ", act: " << to_json({act}) << '\n';
+            }
+        }
+    }
+    return num_fails;
+}
+
+// Full games within a node budget: never worse than the heuristic, and the
+// same serially and in parallel.
+int test_solve_perfect_seeds()
+{
+    const uint64_t NUM_TRIALS = 8;
+    const PerfectSolverOptions options{20000};
+    int num_fails = 0;
+    for (int num_players = 1; num_players <= 2; ++num_players)
+    {
+        const auto serial = solve_perfect_seeds(num_players, 1, 3, NUM_TRIALS, false, options);
+        const auto parallel = solve_perfect_seeds(num_players, 1, 3, NUM_TRIALS, true, options);
+        if (to_json(serial) != to_json(parallel))
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(num_players: " << num_players << ")"
+                      << ", serial: " << to_json(serial)
+                      << ", parallel: " << to_json(parallel) << '\n';
+        }
+        for (const auto &result : serial)
+        {
+            const int heuristic = play_game(ShuffledDeck(result.seed, DeckRng::StdCompat), num_players, 1, 3);
+            if (result.heuristic != heuristic || result.best > heuristic || result.lower_bound > result.best ||
+                result.num_nodes > options.max_nodes)
+            {
+                ++num_fails;
+                std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                          << "(num_players: " << num_players << ", seed: " << result.seed << ")"
+                          << ", heuristic: " << heuristic
+                          << ", result: " << to_json({result});
+            }
+        }
+    }
+    return num_fails;
+}
+
+int main()
+{
+    const int num_fails = test_solve_perfect_small_decks() +
+                          test_solve_perfect_sorted_deck() +
+                          test_get_num_unreachable_cards() +
+                          test_solve_perfect_lower_bound() +
+                          test_solve_perfect_seeds();
+
+    return num_fails != 0;
+}
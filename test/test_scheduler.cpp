@@ -0,0 +1,71 @@
+#include "scheduler.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+
+using namespace TheGameAnalyzer;
+
+// Every chunk is run exactly once, with a thread index in range.
+int test_parallel_for_chunks()
+{
+    struct TestCase
+    {
+        uint64_t num_chunks;
+        unsigned num_threads;
+        bool pin_threads;
+    };
+
+    const TestCase test_cases[] = {
+        {0, 1, false},
+        {0, 4, false},
+        {1, 4, false},
+        {7, 1, false},
+        {7, 8, false},
+        {1000, 2, false},
+        {1000, 3, true},
+        {4096, 16, false},
+    };
+    int num_fails = 0;
+    for (const auto &tc : test_cases)
+    {
+        const auto num_runs = std::make_unique<std::atomic<int>[]>(tc.num_chunks + 1);
+        std::atomic<bool> is_thread_index_ok{true};
+        parallel_for_chunks(tc.num_chunks, {tc.num_threads, tc.pin_threads}, [&](uint64_t chunk_index, unsigned thread_index)
+                            {
+                                // Uneven work, so threads run out at different times and steal.
+                                volatile uint64_t x = 0;
+                                for (uint64_t i = 0; i < (chunk_index % 7) * 1000; ++i)
+                                {
+                                    x = x + i;
+                                }
+                                ++num_runs[chunk_index];
+                                if (thread_index >= tc.num_threads)
+                                {
+                                    is_thread_index_ok = false;
+                                } });
+        bool is_each_run_once = true;
+        for (uint64_t i = 0; i < tc.num_chunks; ++i)
+        {
+            is_each_run_once = is_each_run_once && num_runs[i] == 1;
+        }
+        if (!is_each_run_once || !is_thread_index_ok)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(num_chunks: " << tc.num_chunks
+                      << ", num_threads: " << tc.num_threads
+                      << ", pin_threads: " << tc.pin_threads
+                      << "), each run once: " << is_each_run_once
+                      << ", thread index ok: " << is_thread_index_ok << '\n';
+        }
+    }
+    return num_fails;
+}
+
+int main()
+{
+    const int num_fails = test_parallel_for_chunks();
+
+    return num_fails != 0;
+}
@@ -0,0 +1,195 @@
+#include "sweep.hpp"
+
+#include <cmath>
+#include <iostream>
+
+using namespace TheGameAnalyzer;
+
+// Every cell of a sweep is what play_games gives for that configuration.
+int test_play_sweep()
+{
+    int num_fails = 0;
+    for (const auto deck_rng : {DeckRng::StdCompat, DeckRng::Xoshiro256})
+    {
+        const auto cells = play_sweep({2, 4}, {1, 3}, {2, 4}, 200, true, TurnEngine::Greedy, deck_rng);
+        // Endgame reach distance is never less than the normal one: (1, 2-4), (2, 2-4), (3, 3-4).
+        const size_t exp_num_cells = 3 * (3 + 3 + 2);
+        if (cells.size() != exp_num_cells)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << ", exp num cells: " << exp_num_cells
+                      << ", act: " << cells.size() << '\n';
+        }
+        for (const auto &cell : cells)
+        {
+            const auto exp = play_games(cell.num_players, cell.card_reach_distance_normal,
+                                        cell.card_reach_distance_endgame, 200, false, TurnEngine::Greedy, 0, deck_rng);
+            if (to_string(exp) != to_string(cell.results))
+            {
+                ++num_fails;
+                std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                          << "(num_players: " << cell.num_players
+                          << ", r: " << cell.card_reach_distance_normal
+                          << ", e: " << cell.card_reach_distance_endgame << ")"
+                          << ", exp: " << to_string(exp)
+                          << ", act: " << to_string(cell.results) << '\n';
+            }
+        }
+    }
+    return num_fails;
+}
+
+int test_sweep_to_markdown()
+{
+    std::vector<SweepCell> cells = {
+        {1, 0, 0, {44.53, 11.77, 0.0, 0.0}},
+        {1, 0, 1, {44.53, 11.77, 0.0, 0.0}},
+        {1, 1, 1, {44.86, 11.41, 0.0, 0.0}},
+    };
+    const std::string exp =
+        "## 1 player: excellent game percentage (less than 10 cards remaining)\n"
+        "\n"
+        "| reach distance (normal →) | 0 | 1 |\n"
+        "|---|---|---|\n"
+        "| reach distance (endgame ↓) | | |\n"
+        "| 0 | 44.53 |   |\n"
+        "| 1 | 44.53 | 44.86 |\n"
+        "\n"
+        "## 1 player: beat the game percentage (0 cards remaining)\n"
+        "\n"
+        "| reach distance (normal →) | 0 | 1 |\n"
+        "|---|---|---|\n"
+        "| reach distance (endgame ↓) | | |\n"
+        "| 0 | 11.77 |   |\n"
+        "| 1 | 11.77 | 11.41 |\n"
+        "\n";
+    const auto act = to_markdown(cells);
+    if (exp != act)
+    {
+        std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                  << ", exp:\n"
+                  << exp << "act:\n"
+                  << act;
+        return 1;
+    }
+    return 0;
+}
+
+// The winner's stats are those of play_games() over the same trials,
+// dropped configurations were worse than the leader or the same as it, and
+// each of the 4 rounds' 34 comparisons is corrected for.
+int test_play_race()
+{
+    int num_fails = 0;
+    for (int num_players = MIN_PLAYERS; num_players <= MAX_PLAYERS; ++num_players)
+    {
+        const auto race_result = play_race(num_players, {0, 4}, {0, 8}, 800, 0.95, true);
+        const auto &winner = race_result.cells.front();
+        const auto exp = play_games(num_players, winner.card_reach_distance_normal, winner.card_reach_distance_endgame,
+                                    winner.num_trials, false);
+        bool is_ok = winner.status == RaceCellStatus::Winner &&
+                     race_result.cells.size() == 35 &&
+                     std::abs(race_result.comparison_confidence - (1.0 - 0.05 / (34 * 4))) < 1e-12 &&
+                     race_result.num_games <= race_result.num_games_full_grid &&
+                     std::abs(exp.cards_left_average - winner.cards_left_average) < 1e-9;
+        for (size_t i = 1; i < race_result.cells.size(); ++i)
+        {
+            const auto &cell = race_result.cells[i];
+            is_ok = is_ok && cell.status != RaceCellStatus::Winner;
+            if (cell.status == RaceCellStatus::Dominated)
+            {
+                is_ok = is_ok && cell.cards_left_diff - cell.cards_left_diff_half_width > 0.0;
+            }
+            if (cell.status == RaceCellStatus::Tied)
+            {
+                is_ok = is_ok && cell.cards_left_diff == 0.0 && cell.cards_left_diff_half_width == 0.0;
+            }
+            if (cell.status == RaceCellStatus::Contender)
+            {
+                is_ok = is_ok && cell.num_trials == 800;
+            }
+        }
+        if (!is_ok)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(num_players: " << num_players << ")"
+                      << ", exp winner: " << to_string(exp)
+                      << ", act: " << to_string(race_result);
+        }
+    }
+
+    // A single configuration plays one round and wins.
+    const auto race_result = play_race(3, {2, 2}, {5, 5}, 1000, 0.95, false);
+    if (race_result.cells.size() != 1 || race_result.cells.front().status != RaceCellStatus::Winner ||
+        race_result.num_games != RACE_FIRST_ROUND_TRIALS)
+    {
+        ++num_fails;
+        std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                  << ", act: " << to_string(race_result);
+    }
+
+    // No endgame reach distance is at least a normal one: nothing to race.
+    const auto empty_race_result = play_race(3, {5, 6}, {0, 3}, 200, 0.95, false);
+    if (!empty_race_result.cells.empty() || empty_race_result.num_games != 0)
+    {
+        ++num_fails;
+        std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                  << ", act: " << to_string(empty_race_result);
+    }
+    return num_fails;
+}
+
+// Each strategy gets what play_games gives for it, and each ablation
+// changes the result for some number of players.
+int test_play_strategies()
+{
+    std::vector<Strategy> strategies;
+    for (size_t i = 0; i < NUM_STRATEGIES; ++i)
+    {
+        strategies.push_back(static_cast<Strategy>(i));
+    }
+    std::vector<bool> is_same_as_basic(strategies.size(), true);
+    int num_fails = 0;
+    for (const int num_players : {1, 3})
+    {
+        const auto cells = play_strategies(num_players, 2, 4, strategies, 300, true);
+        for (size_t i = 0; i < cells.size(); ++i)
+        {
+            const auto &cell = cells[i];
+            const auto exp = play_games(num_players, 2, 4, 300, false, TurnEngine::Greedy, 0,
+                                        DeckRng::StdCompat, nullptr, {}, nullptr, cell.strategy);
+            if (cell.strategy != strategies[i] || to_string(exp) != to_string(cell.results))
+            {
+                ++num_fails;
+                std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                          << "(num_players: " << num_players
+                          << ", strategy: " << to_string(strategies[i]) << ")"
+                          << ", exp: " << to_string(exp)
+                          << ", act: " << to_string(cell.results) << '\n';
+            }
+            is_same_as_basic[i] = is_same_as_basic[i] && to_string(cell.results) == to_string(cells.front().results);
+        }
+    }
+    for (size_t i = 1; i < strategies.size(); ++i)
+    {
+        if (is_same_as_basic[i])
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(strategy: " << to_string(strategies[i]) << "), same results as basic\n";
+        }
+    }
+    return num_fails;
+}
+
+int main()
+{
+    const int num_fails = test_play_sweep() +
+                          test_sweep_to_markdown() +
+                          test_play_race() +
+                          test_play_strategies();
+
+    return num_fails != 0;
+}
@@ -1,5 +1,7 @@
 #include "turn.hpp"
 
+#include "strategy.hpp"
+
 #include <iostream>
 #include <sstream>
 #include <vector>
@@ -332,6 +334,68 @@ int test_turn_compare()
     return num_fails;
 }
 
+// Dropping a tiebreaker falls through to the next one.
+int test_strategy_turn_compare()
+{
+    const Turn t1 = {{1, 12, 100, 100}, 0x7, 11, {0, 3, 0, 0}, false};
+    const Turn t2 = {{1, 3, 100, 100}, 0x3, 2, {0, 2, 0, 0}, false};
+    const Turn t3 = {{1, 3, 100, 100}, 0x7, 2, {0, 3, 0, 0}, true};
+    struct TestCase
+    {
+        bool act;
+        bool exp;
+        std::string name;
+    };
+    const TestCase test_cases[] = {
+        {StrategyTurnCompare<BasicStrategy>{2}(t1, t2), true, "basic, 2. smaller delta"},
+        {StrategyTurnCompare<NoDeltaTiebreakStrategy>{2}(t1, t2), false, "no delta, 4. more cards"},
+        {StrategyTurnCompare<BasicStrategy>{2}(t3, t2), true, "basic, 3. no group reach"},
+        {StrategyTurnCompare<NoGroupReachTiebreakStrategy>{2}(t3, t2), false, "no group reach, 4. more cards"},
+        {StrategyTurnCompare<NoMoreCardsTiebreakStrategy>{2}(t2, t3), false, "no more cards, 3. no group reach"},
+        {StrategyTurnCompare<NoPileExtremesTiebreakStrategy>{2}(t2, t2), false, "no pile extremes, equal"},
+    };
+    int num_fails = 0;
+    for (const auto &tc : test_cases)
+    {
+        if (tc.exp != tc.act)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(" << tc.name << ")"
+                      << ", exp: " << tc.exp
+                      << ", act: " << tc.act << "\n";
+        }
+    }
+    return num_fails;
+}
+
+// Only ReachNearGroupCard reaches into the 4-14 group.
+int test_find_best_turn_strategy()
+{
+    const Hand hand = {2, 3, 4, 14, 50, 60, 70, 80};
+    const Piles piles = {1, 1, 100, 100};
+    const Turn exp_basic = {{1, 3, 100, 100}, 0x3, 2, {0, 2, 0, 0}, false};
+    const Turn exp_reach = {{1, 4, 100, 100}, 0xf, 3, {0, 3, 0, 0}, true};
+    const Turn act[] = {
+        find_best_turn<BasicStrategy>(piles, hand, CardSet(), 2, 1),
+        find_best_turn<ReachNearGroupCardStrategy>(piles, hand, CardSet(), 2, 1),
+    };
+    const Turn exp[] = {exp_basic, exp_reach};
+    int num_fails = 0;
+    for (size_t i = 0; i < std::size(exp); ++i)
+    {
+        if (exp[i] != act[i])
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(i: " << i << ")"
+                      << ", exp: " << to_string(exp[i])
+                      << ", act: " << to_string(act[i]) << "\n";
+        }
+    }
+    return num_fails;
+}
+
 int test_find_best_turn_2_1()
 {
     struct TestCase
@@ -363,6 +427,38 @@ int test_find_best_turn_2_1()
     return num_fails;
 }
 
+// CardMemory jumps over played cards for free, in both directions, and
+// other strategies ignore the played cards.
+int test_find_best_turn_card_memory()
+{
+    const Hand hand = {2, 3, 6, 50, 60, 94, 97, 98};
+    const Piles piles = {1, 1, 100, 100};
+    const CardSet played_cards(std::array<Card, 4>{4, 5, 95, 96});
+    const Turn exp_basic = {{1, 3, 100, 100}, 0x3, 2, {0, 2, 0, 0}, false};
+    const Turn exp_memory = {{1, 6, 100, 100}, 0x7, 3, {0, 3, 0, 0}, false};
+    const Piles descending_piles = {61, 61, 100, 100};
+    const Turn act[] = {
+        find_best_turn<CardMemoryStrategy>(piles, hand, CardSet(), 2, 1),
+        find_best_turn<CardMemoryStrategy>(piles, hand, played_cards, 2, 1),
+        find_best_turn<BasicStrategy>(piles, hand, played_cards, 2, 1),
+        find_best_turn<CardMemoryStrategy>(descending_piles, hand, played_cards, 2, 1),
+    };
+    const Turn exp[] = {exp_basic, exp_memory, exp_basic, {{61, 61, 94, 100}, 0xe0, 4, {0, 0, 3, 0}, false}};
+    int num_fails = 0;
+    for (size_t i = 0; i < std::size(exp); ++i)
+    {
+        if (exp[i] != act[i])
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(i: " << i << ")"
+                      << ", exp: " << to_string(exp[i])
+                      << ", act: " << to_string(act[i]) << "\n";
+        }
+    }
+    return num_fails;
+}
+
 int main()
 {
     const int num_fails = test_flip_hand() +
@@ -371,6 +467,9 @@ int main()
                           test_get_ten_groups() +
                           test_get_plays_ascending_2_cards_1_over() +
                           test_turn_compare() +
+                          test_strategy_turn_compare() +
+                          test_find_best_turn_strategy() +
+                          test_find_best_turn_card_memory() +
                           test_find_best_turn_2_1();
 
     return num_fails != 0;
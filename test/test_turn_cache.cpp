@@ -0,0 +1,86 @@
+#include "game.hpp"
+#include "turn_cache.hpp"
+
+#include <iostream>
+
+using namespace TheGameAnalyzer;
+
+int test_turn_cache_find_insert()
+{
+    struct TestCase
+    {
+        Piles piles;
+        Hand hand;
+        int min_cards_for_turn;
+        int card_reach_distance;
+    };
+
+    const TestCase test_cases[] = {
+        {{1, 1, 100, 100}, {2, 8, 11, 20, 24, 53, 57, 92}, 2, 1},
+        {{1, 8, 100, 100}, {6, 11, 20, 24, 51, 53, 57, 92}, 2, 1},
+        {{19, 61, 73, 81}, {3, 13, 37, 65, 74, 89, 95, 96}, 2, 3},
+        {{30, 93, 42, 71}, {3, 4, 5, 12, 13, 14, 15, 50}, 1, 5},
+        {{30, 93, 14, 71}, {3, 13, 46}, 1, 1},
+        {{50, 50, 40, 40}, {45}, 1, 3},
+    };
+    int num_fails = 0;
+    TurnCache turn_cache(1 << 20);
+    for (const auto &tc : test_cases)
+    {
+        const auto key = make_turn_cache_key(tc.piles, tc.hand, tc.min_cards_for_turn, tc.card_reach_distance, 0);
+        const auto turn = find_best_turn(tc.piles, tc.hand, tc.min_cards_for_turn, tc.card_reach_distance);
+        const auto before = turn_cache.find(key);
+        turn_cache.insert(key, turn);
+        const auto after = turn_cache.find(key);
+        // Same position with another engine id is a different key.
+        const auto other_engine = turn_cache.find(
+            make_turn_cache_key(tc.piles, tc.hand, tc.min_cards_for_turn, tc.card_reach_distance, 1));
+        if (before || !after || *after != turn || other_engine)
+        {
+            ++num_fails;
+            std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                      << "(piles: " << to_string(tc.piles)
+                      << ", hand: " << to_string(tc.hand)
+                      << "), turn: " << to_string(turn)
+                      << ", before: " << (before ? to_string(*before) : "none")
+                      << ", after: " << (after ? to_string(*after) : "none")
+                      << ", other_engine: " << (other_engine ? to_string(*other_engine) : "none") << '\n';
+        }
+    }
+    return num_fails;
+}
+
+// A cache too small to hold everything still gives the same games.
+int test_play_games_with_turn_cache()
+{
+    int num_fails = 0;
+    for (const auto turn_engine : {TurnEngine::Greedy, TurnEngine::Exhaustive})
+    {
+        for (int num_players = MIN_PLAYERS; num_players <= MAX_PLAYERS; ++num_players)
+        {
+            const auto exp = play_games(num_players, 1, 3, 50, false, turn_engine);
+            const auto act = play_games(num_players, 1, 3, 50, true, turn_engine, 1 << 12);
+            if (exp.cards_left_average != act.cards_left_average ||
+                exp.cards_left_stddev != act.cards_left_stddev ||
+                !act.turn_cache_stats || act.turn_cache_stats->lookups == 0 ||
+                act.turn_cache_stats->bytes > (1 << 12))
+            {
+                ++num_fails;
+                std::cerr << __FILE__ << ":" << __LINE__ << ". FAIL, " << __FUNCTION__
+                          << "(num_players: " << num_players
+                          << ", turn_engine: " << static_cast<int>(turn_engine)
+                          << "), exp: " << to_string(exp)
+                          << ", act: " << to_string(act) << '\n';
+            }
+        }
+    }
+    return num_fails;
+}
+
+int main()
+{
+    const int num_fails = test_turn_cache_find_insert() +
+                          test_play_games_with_turn_cache();
+
+    return num_fails != 0;
+}